@@ -0,0 +1,441 @@
+/* Extensions to the hash table project API. hashTable.h must stay unmodified,
+ * so every feature beyond the original project lives in this header. Tables
+ * created by htCreateOpts are used with the regular hashTable.h functions.
+ */
+#ifndef HASHTABLEEXT_H
+#define HASHTABLEEXT_H
+
+#include "hashTable.h"
+
+/* Function type for htForEach.
+ *
+ *    FNVisit: Called with each entry and the context passed to htForEach.
+ *       Returns nonzero to stop the walk, 0 to go on.
+ */
+typedef int (*FNVisit)(HTEntry entry, void *context);
+
+/* Cursor over the entries of a table, see htIterInit. The fields belong to
+ * the table, it lives wherever the caller puts it.
+ */
+typedef struct
+{
+   void *table;
+   unsigned index;
+   unsigned node;
+} HTIterator;
+
+/* Largest HTOptions.inlineKeyWidth. */
+#define HT_MAX_INLINE_KEY 255
+
+/* Function type for tables with inline keys (see HTOptions).
+ *
+ *    FNKeySize: Returns the number of bytes making up the key of data, e.g.
+ *       strlen(data) + 1 for C strings. Two data items must compare equal
+ *       exactly when these bytes are equal.
+ */
+typedef size_t (*FNKeySize)(const void *data);
+
+/* Function type for tables with an equality test (see HTOptions).
+ *
+ *    FNEqual: Returns nonzero when data1 and data2 are the same data, 0
+ *       otherwise.
+ */
+typedef int (*FNEqual)(const void *data1, const void *data2);
+
+/* Function type for tables with 64 bit hashes (see HTOptions).
+ *
+ *    FNHash64: Like FNHash but returns all the bits of unsigned long. Where
+ *       unsigned long has only 32 bits this is no better than FNHash.
+ */
+typedef unsigned long (*FNHash64)(const void *data);
+
+/* Function type for tables with slice keys (see HTOptions).
+ *
+ *    FNHashBytes: Returns the hash of the len bytes at key. Must equal what
+ *       FNHash returns for a nul-terminated string of the same bytes, as
+ *       htHashSlice does for htHashString.
+ */
+typedef unsigned (*FNHashBytes)(const void *key, size_t len);
+
+/* Storage engines a table can be created with.
+ *
+ *    HT_CHAINED: Default. Each bucket is its own allocation holding the
+ *       entries that hash to it.
+ *    HT_OPEN: Robin Hood linear probing over one flat slot array. No per
+ *       bucket allocations and no pointer chase before the first compare.
+ *       Because every entry needs a slot, a full table grows even when the
+ *       load factor is 1.0: to the next size if there is one, otherwise as
+ *       HTOptions.growth says or, with HT_GROW_LADDER, to 2 * capacity + 1.
+ *    HT_ATOMIC: Lock-free counting. htAdd, htLookUp, htAddBatch,
+ *       htLookUpBatch, htUniqueEntries and htTotalEntries may be called from
+ *       several threads at once; adding data already in the table is a
+ *       single atomic increment of its frequency and lookups never wait
+ *       unless a resize is copying the slots. Entries cannot be removed
+ *       (no htRemove, htDecrement, htShrinkToFit or htReserve) and the
+ *       table grows like HT_OPEN. Every other function still needs the
+ *       table to itself. Only with the default layout, no rehashStep,
+ *       tagged, inlineKeyWidth, hash64, hashBytes, shrinkLoadFactor or
+ *       stripes.
+ */
+typedef enum
+{
+   HT_CHAINED,
+   HT_OPEN,
+   HT_ATOMIC
+} HTEngine;
+
+/* Slot layouts of the open addressing engine.
+ *
+ *    HT_AOS: Default. One array of slots, each holding data, frequency and
+ *       hash together. A probe reads a single cache line per slot.
+ *    HT_SOA: Data pointers, hashes and frequencies in three separate
+ *       arrays. Full table scans (htToArray, htMetrics, htDestroy) stream
+ *       only the arrays they need.
+ */
+typedef enum
+{
+   HT_AOS,
+   HT_SOA
+} HTLayout;
+
+/* What a table does once it has rehashed to the last entry of sizes[].
+ *
+ *    HT_GROW_LADDER: Default. Stays at the last size, chains grow without
+ *       bound (open tables still grow when completely full, see HT_OPEN).
+ *    HT_GROW_PRIME: Keeps rehashing to the first prime of a built-in table
+ *       that is at least twice the capacity.
+ *    HT_GROW_POW2: Keeps rehashing to the first power of two that is at
+ *       least twice the capacity.
+ *
+ * Growth past the ladder follows rehashLoadFactor like the ladder itself, a
+ * factor of 1.0 still never rehashes. Capacities stop growing at INT_MAX.
+ */
+typedef enum
+{
+   HT_GROW_LADDER,
+   HT_GROW_PRIME,
+   HT_GROW_POW2
+} HTGrowth;
+
+/* Creation options for htCreateOpts. Start from htDefaultOptions and change
+ * only the fields of interest so new fields keep their defaults.
+ */
+typedef struct
+{
+   HTEngine engine;
+
+   /* Buckets moved per htAdd/htLookUp while an incremental rehash is in
+    * progress. 0 (default) moves every entry inside the htAdd that crosses
+    * the load factor. Otherwise the old and new arrays coexist until the
+    * migration finishes, bounding the work of any one call. Choose a step
+    * large enough to finish before the next size is reached, a rehash that
+    * starts early finishes the previous one first. HT_CHAINED only.
+    */
+   unsigned rehashStep;
+
+   /* Nonzero keeps a control byte per slot holding 7 bits of the hash.
+    * Lookups test a group of control bytes at once (SSE2, AVX2 when built
+    * with -mavx2, portable loop otherwise) and only touch slots whose tag
+    * matches, so absent data rarely reaches FNCompare. HT_OPEN only.
+    */
+   int tagged;
+
+   /* Slot layout, see HTLayout. HT_OPEN only. */
+   HTLayout layout;
+
+   /* Nonzero stores keys of at most this many bytes (as reported by
+    * keySize) inside the table and compares them with memcmp; longer keys
+    * keep using their data pointer and FNCompare. HT_OPEN only, at most
+    * HT_MAX_INLINE_KEY, requires keySize and no FNDestroy.
+    *
+    * IMPORTANT: htAdd frees new data whose key is stored inline right away,
+    *            the caller must not use it afterwards. The data htLookUp
+    *            and htToArray return for such entries points into the table
+    *            and is only valid until the next htAdd.
+    */
+   unsigned inlineKeyWidth;
+   FNKeySize keySize;
+
+   /* Growth past the last size, see HTGrowth. */
+   HTGrowth growth;
+
+   /* When set, used instead of HTFunctions.hash, which is then never
+    * called. The low 32 bits pick the bucket, the high 32 bits are kept
+    * with every entry so scans reject other data without FNCompare even
+    * when the low bits collide. Tagged tables take their tags from the high
+    * bits. Costs 4 more bytes per entry.
+    */
+   FNHash64 hash64;
+
+   /* Enables htAddSlice and htLookUpSlice. The table's data must then be
+    * nul-terminated strings compared like strcmp, see FNHashBytes. Not
+    * with hash64.
+    */
+   FNHashBytes hashBytes;
+
+   /* When set, every lookup and duplicate check of htAdd uses it instead of
+    * HTFunctions.compare, which may then be NULL. Lets an equality test
+    * skip the ordering work a compare has to do, e.g. by checking lengths
+    * first.
+    */
+   FNEqual equal;
+
+   /* Low-water mark: when htRemove or htDecrement leaves the load below
+    * it, the table rehashes down to the smallest capacity that holds its
+    * entries at no more than half of rehashLoadFactor, see htShrinkToFit.
+    * 0 (default) never shrinks on its own. Must be below rehashLoadFactor.
+    */
+   float shrinkLoadFactor;
+
+   /* Nonzero makes htAdd, htLookUp, htAddBatch, htLookUpBatch, htRemove,
+    * htDecrement, htUniqueEntries and htTotalEntries safe to call from
+    * several threads at once. Buckets are split between this many mutexes
+    * (bucket h to mutex h % stripes), so only calls landing on the same
+    * stripe wait for each other; a rehash takes them all. The counts read
+    * while other threads change the table are a recent snapshot. Every
+    * other function still needs the table to itself. HT_CHAINED only,
+    * without rehashStep, hashBytes or shrinkLoadFactor.
+    */
+   unsigned stripes;
+
+   /* Threads that share the work of a rehash. 0 and 1 (default) move
+    * every entry on the calling thread. Otherwise each thread moves the
+    * entries of a range of at least 16384 old buckets, so smaller tables
+    * still rehash on one thread. HT_CHAINED only, without rehashStep.
+    */
+   unsigned rehashThreads;
+} HTOptions;
+
+/* Description: Returns the options htCreate uses.
+ */
+HTOptions htDefaultOptions(void);
+
+/* Description: Creates a new hash table exactly like htCreate but with the
+ *    specified options.
+ *
+ * Notes:
+ *    1. Asserts under the same conditions as htCreate.
+ *    2. A NULL options pointer is the same as htDefaultOptions.
+ *
+ * Parameters:
+ *    functions, sizes, numSizes, rehashLoadFactor: See htCreate.
+ *    options: The creation options, copied by the table.
+ *
+ * Return: A pointer usable with every hashTable.h function.
+ */
+void* htCreateOpts(
+   HTFunctions *functions,
+   unsigned sizes[],
+   int numSizes,
+   float rehashLoadFactor,
+   HTOptions *options
+);
+
+/* Description: Adds the string made of the len bytes at key, like htAdd
+ *    with a nul-terminated copy of them.
+ *
+ * Notes:
+ *    1. Asserts if the table was created without HTOptions.hashBytes or
+ *       key is NULL.
+ *    2. The bytes are only copied when the string is new, into memory the
+ *       table allocates (or into the slot with inline keys) and frees like
+ *       any other data. The caller keeps ownership of key.
+ *    3. key must not contain nul bytes.
+ *
+ * Return: See htAdd.
+ */
+unsigned htAddSlice(void *hashTable, const char *key, size_t len);
+
+/* Description: Looks up the string made of the len bytes at key without
+ *    allocating, like htLookUp with a nul-terminated copy of them.
+ *
+ * Notes:
+ *    1. Asserts under the same conditions as htAddSlice.
+ *
+ * Return: See htLookUp, the data returned is the table's copy.
+ */
+HTEntry htLookUpSlice(void *hashTable, const char *key, size_t len);
+
+/* Description: Removes the entry matching data whatever its frequency.
+ *
+ * Notes:
+ *    1. The table frees the data it stored for the entry like htDestroy
+ *       does. data itself is only read, it may be the stored data (as
+ *       returned by htLookUp), which is then freed.
+ *    2. No tombstones are left behind: chained buckets shrink and are freed
+ *       once empty, open addressing entries after the removed one shift back
+ *       toward their home slot.
+ *    3. htUniqueEntries drops by one and htTotalEntries by the frequency.
+ *    4. The capacity is left unchanged.
+ *    5. Asserts if data is NULL.
+ *
+ * Return: The frequency the entry had, 0 if data was not in the table.
+ */
+unsigned htRemove(void *hashTable, void *data);
+
+/* Description: Decrements the frequency of the entry matching data,
+ *    removing it like htRemove when the frequency reaches 0.
+ *
+ * Notes:
+ *    1. htTotalEntries drops by one when data was in the table.
+ *    2. Asserts if data is NULL.
+ *
+ * Return: The new frequency, 0 if the entry was removed or data was not in
+ *    the table.
+ */
+unsigned htDecrement(void *hashTable, void *data);
+
+/* Description: Rehashes the table down to the smallest capacity that holds
+ *    its entries without exceeding rehashLoadFactor.
+ *
+ * Notes:
+ *    1. Candidates are the sizes of the ladder and, past it, the capacities
+ *       of the growth policy. The table's position on the ladder moves back
+ *       with it so it grows again the way it did the first time.
+ *    2. Does nothing when no smaller capacity fits.
+ *    3. Finishes any incremental rehash. Bucket memory of a chained table
+ *       goes back to the table's own allocator for reuse, the bucket array
+ *       and open addressing slots go back to the system.
+ */
+void htShrinkToFit(void *hashTable);
+
+/* Description: Rehashes the table straight to the first capacity that
+ *    holds expected unique entries without exceeding rehashLoadFactor, so
+ *    adding them needs no rehash on the way.
+ *
+ * Notes:
+ *    1. Candidates are the sizes of the ladder after the current one and,
+ *       past it, the capacities of the growth policy. When none is large
+ *       enough the table moves to the largest of them.
+ *    2. Does nothing when the current capacity is large enough, the table
+ *       never shrinks here.
+ *    3. Finishes any incremental rehash.
+ */
+void htReserve(void *hashTable, unsigned expected);
+
+/* Description: Returns the bytes the allocator of a chained table holds
+ *    from the system for its buckets, those of every stripe included.
+ *
+ * Notes:
+ *    1. Whole blocks are counted, free chunks in them included. They only
+ *       go back to the system when htShrinkToFit compacts a table without
+ *       stripes, and on htDestroy.
+ *    2. 0 for HT_OPEN and HT_ATOMIC tables, whose slots are plain arrays.
+ */
+size_t htArenaBytes(void *hashTable);
+
+/* Description: Positions it before the first entry of the table.
+ *
+ * Notes:
+ *    1. Iterating allocates and copies nothing, entries are read in place
+ *       in the same order htToArray returns them.
+ *    2. Any htAdd, htRemove or other change to the table ends the
+ *       iteration. So does htLookUp while an incremental rehash is in
+ *       progress, since it moves entries.
+ */
+void htIterInit(void *hashTable, HTIterator *it);
+
+/* Description: Advances it to the next entry of its table.
+ *
+ * Return: Nonzero with the entry in *entry, 0 once every entry has been
+ *    visited.
+ */
+int htIterNext(HTIterator *it, HTEntry *entry);
+
+/* Description: Calls visit with every entry of the table, stopping early
+ *    when it returns nonzero.
+ *
+ * Notes:
+ *    1. visit must not change the table, see htIterInit.
+ *
+ * Return: The number of entries visit was called with.
+ */
+unsigned htForEach(void *hashTable, FNVisit visit, void *context);
+
+/* Description: Finds the k entries with the highest frequencies.
+ *
+ * Notes:
+ *    1. One pass over the table keeping a heap of k entries in out, so it
+ *       takes O(N log k) time and allocates nothing.
+ *    2. Entries with equal frequencies come in no particular order, which
+ *       of them make the cut at the k-th frequency is unspecified.
+ *
+ * Parameters:
+ *    out: Room for k entries, filled with highest frequency first.
+ *
+ * Return: The number of entries stored in out, the smaller of k and
+ *    htUniqueEntries.
+ */
+unsigned htTopK(void *hashTable, unsigned k, HTEntry out[]);
+
+/* Description: htTopK with the table split into ranges walked by separate
+ *    threads, each keeping its own heap of k entries; the heaps are merged
+ *    into out.
+ *
+ * Notes:
+ *    1. Allocates k entries per thread. The calling thread is one of them.
+ *    2. Worth it only for tables much larger than the cache. threads of 0
+ *       or 1 is htTopK.
+ *    3. The table must not be used by other threads meanwhile.
+ */
+unsigned htTopKParallel(void *hashTable, unsigned k, HTEntry out[],
+   unsigned threads);
+
+/* Description: Adds count values, like calling htAdd on each of data[0]
+ *    to data[count - 1] in order.
+ *
+ * Notes:
+ *    1. Keys are hashed a chunk at a time and the memory each one will probe
+ *       is prefetched before any of them is resolved, so the cache misses of
+ *       a chunk overlap instead of following each other. Pays off on tables
+ *       larger than the cache.
+ *    2. Duplicates within data behave as with repeated htAdd calls.
+ *    3. freqs[i] gets what htAdd would have returned for data[i], freqs may
+ *       be NULL.
+ *    4. Asserts like htAdd on any NULL data[i].
+ */
+void htAddBatch(void *hashTable, void *data[], unsigned count,
+   unsigned freqs[]);
+
+/* Description: Looks up count values, entries[i] getting what
+ *    htLookUp(hashTable, data[i]) would return.
+ *
+ * Notes:
+ *    1. Prefetches like htAddBatch.
+ */
+void htLookUpBatch(void *hashTable, void *data[], unsigned count,
+   HTEntry entries[]);
+
+/* Description: Moves every entry of src into dst and destroys src, adding
+ *    the frequencies of data found in both.
+ *
+ * Notes:
+ *    1. Entries keep the hash src stored with them, FNHash is not called.
+ *       Both tables must therefore hash alike, and free data alike since
+ *       dst takes over data of src: asserts unless they have the same
+ *       FNHash, hash64 and FNDestroy. src must not store inline keys.
+ *    2. Data new to dst is handed to it as is. Data dst already holds is
+ *       freed as htDestroy(src) would free it.
+ *    3. Unless dst is thread safe it is first grown, like htReserve, to
+ *       hold as many entries as the larger of the two tables.
+ *    4. Other threads may use dst meanwhile if it is thread safe, never
+ *       src.
+ */
+void htMerge(void *dst, void *src);
+
+/* Description: Merges count tables into one, as a tree: pairs are merged on
+ *    separate threads, then pairs of the results and so on.
+ *
+ * Notes:
+ *    1. Each merge keeps the table with more entries and moves the other
+ *       into it, see htMerge, so which of the tables survives depends on
+ *       their contents.
+ *    2. Merges of a round for which a thread cannot be started run on the
+ *       calling thread, which always takes the first one.
+ *    3. None of the tables may be used by other threads meanwhile.
+ *
+ * Return: The merged table, every other table is destroyed.
+ */
+void* htMergeParallel(void *tables[], unsigned count);
+
+#endif
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hasharena.h"
+#include "hashmacros.h"
+
+#define ARENA_ALIGN sizeof(double)
+
+HashArena* arenaCreate() {
+   int i;
+   HashArena *arena = malloc(sizeof(HashArena));
+   CHECK_ALLOC(arena);
+   arena->blocks = NULL;
+   arena->next = NULL;
+   arena->end = NULL;
+   arena->blockSize = ARENA_FIRST_BLOCK;
+   arena->bytes = 0;
+   for (i = 0; i < ARENA_CLASSES; i++) {
+      arena->freeLists[i] = NULL;
+      arena->freeTails[i] = NULL;
+   }
+   return arena;
+}
+
+static void* newBlock(HashArena *arena, size_t size) {
+   ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+   CHECK_ALLOC(block);
+   block->next = arena->blocks;
+   arena->blocks = block;
+   arena->bytes += sizeof(ArenaBlock) + size;
+   return block + 1;
+}
+
+void* arenaAlloc(HashArena *arena, unsigned sizeClass, size_t size) {
+   /* every chunk of a class must have the same size */
+   void *chunk;
+   if ((chunk = arena->freeLists[sizeClass]) != NULL) {
+      arena->freeLists[sizeClass] = *(void**)chunk;
+      return chunk;
+   }
+   size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+   /* chunks bigger than a quarter block get a block of their own */
+   if (size > arena->blockSize / 4)
+      return newBlock(arena, size);
+   if (arena->next == NULL || (size_t)(arena->end - arena->next) < size) {
+      /* the tail of the old block is abandoned, at most a quarter block */
+      arena->next = newBlock(arena, arena->blockSize);
+      arena->end = arena->next + arena->blockSize;
+      if (arena->blockSize < ARENA_MAX_BLOCK)
+         arena->blockSize *= 2;
+   }
+   chunk = arena->next;
+   arena->next += size;
+   return chunk;
+}
+
+void arenaFree(HashArena *arena, void *chunk, unsigned sizeClass) {
+   if (arena->freeLists[sizeClass] == NULL)
+      arena->freeTails[sizeClass] = chunk;
+   *(void**)chunk = arena->freeLists[sizeClass];
+   arena->freeLists[sizeClass] = chunk;
+}
+
+void arenaAdopt(HashArena *arena, HashArena *other) {
+   /* takes over the blocks and free chunks of other and destroys it; chunks
+    * freed to either arena may come from the other's blocks */
+   ArenaBlock *last;
+   unsigned i;
+   if (other->blocks != NULL) {
+      for (last = other->blocks; last->next != NULL; last = last->next)
+         ;
+      last->next = arena->blocks;
+      arena->blocks = other->blocks;
+   }
+   for (i = 0; i < ARENA_CLASSES; i++) {
+      if (other->freeLists[i] == NULL)
+         continue;
+      *(void**)other->freeTails[i] = arena->freeLists[i];
+      if (arena->freeLists[i] == NULL)
+         arena->freeTails[i] = other->freeTails[i];
+      arena->freeLists[i] = other->freeLists[i];
+   }
+   /* only one block can be carved from, keep the one with more room */
+   if (other->end - other->next > arena->end - arena->next) {
+      arena->next = other->next;
+      arena->end = other->end;
+   }
+   if (other->blockSize > arena->blockSize)
+      arena->blockSize = other->blockSize;
+   arena->bytes += other->bytes;
+   free(other);
+}
+
+void arenaDestroy(HashArena *arena) {
+   ArenaBlock *block, *next;
+   for (block = arena->blocks; block != NULL; block = next) {
+      next = block->next;
+      free(block);
+   }
+   free(arena);
+}
@@ -0,0 +1,39 @@
+#ifndef HASHARENA_H
+#define HASHARENA_H
+
+#include <stdlib.h>
+
+#define ARENA_CLASSES 32
+#define ARENA_FIRST_BLOCK 16384
+#define ARENA_MAX_BLOCK (16 * 1024 * 1024)
+
+/* header of every block the arena gets from malloc */
+typedef struct arenaBlock
+{
+   struct arenaBlock *next;
+   double align;
+}  ArenaBlock;
+
+/* Per table allocator. Chunks are carved from large blocks and recycled by
+ * size class, nothing is returned to malloc until arenaDestroy. freeTails
+ * holds the last chunk of every free list that is not empty, bytes the
+ * size of all blocks together.
+ */
+typedef struct
+{
+   ArenaBlock *blocks;
+   char *next;
+   char *end;
+   size_t blockSize;
+   size_t bytes;
+   void *freeLists[ARENA_CLASSES];
+   void *freeTails[ARENA_CLASSES];
+}  HashArena;
+
+HashArena* arenaCreate();
+void* arenaAlloc(HashArena *arena, unsigned sizeClass, size_t size);
+void arenaFree(HashArena *arena, void *chunk, unsigned sizeClass);
+void arenaAdopt(HashArena *arena, HashArena *other);
+void arenaDestroy(HashArena *arena);
+
+#endif
@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hashTable.h"
+#include "hashatomic.h"
+#include "hashlib.h"
+#include "hashmacros.h"
+
+/* Lock-free counting engine. Every entry is a HashNode of its own and a
+ * slot only ever changes once, from NULL to the node, with a compare and
+ * swap; linear probing finds it after that. Adding a duplicate is one
+ * atomic increment of the node's frequency (and one of a counter line
+ * shared with a 64th of the hashes), lookups take no lock at all.
+ *
+ * Resizes are serialized by a mutex. The resizing thread closes every
+ * empty slot of the old generation with MOVED and copies the node pointers
+ * it finds into the new one. Nodes never move, so increments made through
+ * a stale generation are not lost, and a slot closed before a new key
+ * could claim it sends that thread to wait for the new generation. Old
+ * generations stay allocated until htDestroy since lock-free readers may
+ * still be scanning them; as capacities at least double their total stays
+ * below the size of the current one.
+ */
+
+static HashNode movedNode;
+#define MOVED (&movedNode)
+
+static unsigned growLimit(HashTable *ht, unsigned cap) {
+   /* the load factor while a larger capacity follows, and never more than
+    * 7/8 full since probing needs empty slots */
+   double full = cap * 0.875, factor = *(ht->rehashFactor);
+   if (factor != 1.0 && factor * cap < full &&
+      (ht->nums[CUR_SIZE_INDEX] + 1 != ht->nums[NUM_SIZES] ||
+      growthStep(ht, cap) != 0))
+      return factor * cap;
+   return full;
+}
+
+static AtomicSlots* slotsNew(HashTable *ht, unsigned cap) {
+   AtomicSlots *arr = malloc(sizeof(AtomicSlots));
+   CHECK_ALLOC(arr);
+   arr->slots = calloc(cap, sizeof(HashNode*));
+   CHECK_ALLOC(arr->slots);
+   arr->cap = cap;
+   arr->limit = growLimit(ht, cap);
+   arr->retired = NULL;
+   reducerInit(&(arr->reduce), cap);
+   return arr;
+}
+
+AtomicTable* atomicCreate(HashTable *ht, unsigned cap) {
+   int i;
+   AtomicTable *at = malloc(sizeof(AtomicTable));
+   CHECK_ALLOC(at);
+   if (pthread_mutex_init(&(at->grow), NULL) != 0) {
+      fprintf(stderr, "ERROR: mutex init: %s: %d\n", __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < ATOMIC_LINES; i++) {
+      at->lines[i].count.unique = 0;
+      at->lines[i].count.total = 0;
+   }
+   at->current = slotsNew(ht, cap);
+   return at;
+}
+
+void atomicDestroy(HashTable *ht, int keepData) {
+   /* every node is in the current generation */
+   AtomicTable *at = ht->atomic;
+   AtomicSlots *arr = at->current, *next;
+   unsigned i;
+   for (i = 0; i < arr->cap; i++) {
+      if (arr->slots[i] == NULL)
+         continue;
+      if (!keepData)
+         freeData(arr->slots[i]->data, ht->funcs->destroy);
+      free(arr->slots[i]);
+   }
+   for (; arr != NULL; arr = next) {
+      next = arr->retired;
+      free(arr->slots);
+      free(arr);
+   }
+   pthread_mutex_destroy(&(at->grow));
+   free(at);
+}
+
+static void atomicGrow(HashTable *ht, AtomicSlots *seen, int full) {
+   /* replaces generation seen unless another thread already has or, when
+    * it is not full, the real count is still below its limit */
+   AtomicTable *at = ht->atomic;
+   AtomicSlots *arr;
+   HashNode *node;
+   unsigned i, j, cap;
+   pthread_mutex_lock(&(at->grow));
+   if (ATOMIC_LOAD(&(at->current)) != seen ||
+      (!full && (unsigned)atomicSum(ht, 1) <= seen->limit)) {
+      pthread_mutex_unlock(&(at->grow));
+      return;
+   }
+   /* the capacities htAdd on an HT_OPEN table would go through */
+   if (ht->nums[CUR_SIZE_INDEX] + 1 != ht->nums[NUM_SIZES])
+      cap = ht->sizes[++(ht->nums[CUR_SIZE_INDEX])];
+   else if ((cap = growthStep(ht, seen->cap)) == 0)
+      cap = 2 * seen->cap + 1;
+   ht->nums[CAP] = cap;
+   arr = slotsNew(ht, cap);
+   for (i = 0; i < seen->cap; i++) {
+      node = NULL;
+      if (ATOMIC_CAS(seen->slots + i, &node, MOVED))
+         continue;
+      for (j = REDUCE(&(arr->reduce), node->hash); arr->slots[j] != NULL;
+         j = (j + 1 == cap) ? 0 : j + 1)
+         ;
+      arr->slots[j] = node;
+   }
+   arr->retired = seen;
+   ATOMIC_STORE(&(at->current), arr);
+   pthread_mutex_unlock(&(at->grow));
+}
+
+static void atomicWait(HashTable *ht) {
+   /* MOVED is only written while a resize holds the mutex */
+   pthread_mutex_lock(&(ht->atomic->grow));
+   pthread_mutex_unlock(&(ht->atomic->grow));
+}
+
+unsigned atomicAdd(HashTable *ht, void *data, unsigned hash,
+   unsigned count) {
+   AtomicTable *at = ht->atomic;
+   /* mixed first, hashes that only vary in their low bits would all share
+    * one line and make it count for the whole table */
+   AtomicLine *line = at->lines + (htMix32(hash) >> ATOMIC_LINE_SHIFT);
+   AtomicSlots *arr;
+   HashNode *node = NULL, *seen;
+   unsigned i, probes, freq;
+   for (;;) {
+      arr = ATOMIC_LOAD(&(at->current));
+      i = REDUCE(&(arr->reduce), hash);
+      for (probes = 0; probes < arr->cap; probes++) {
+         seen = ATOMIC_LOAD(arr->slots + i);
+         if (seen == NULL) {
+            /* allocated once, however many slots it races for */
+            if (node == NULL) {
+               node = malloc(sizeof(HashNode));
+               CHECK_ALLOC(node);
+               node->data = data;
+               node->hash = hash;
+               node->frequency = count;
+            }
+            if (ATOMIC_CAS(arr->slots + i, &seen, node)) {
+               ATOMIC_BUMP(&(line->count.unique), 1);
+               ATOMIC_BUMP(&(line->count.total), count);
+               /* the line only estimates the total, which is summed
+                * before taking the mutex */
+               if ((unsigned long)ATOMIC_PEEK(&(line->count.unique)) *
+                  ATOMIC_LINES > arr->limit &&
+                  (unsigned)atomicSum(ht, 1) > arr->limit)
+                  atomicGrow(ht, arr, 0);
+               return count;
+            }
+         }
+         if (seen == MOVED)
+            break;
+         if (seen->hash == hash && MATCHES(ht->match, seen->data, data)) {
+            free(node);
+            freq = ATOMIC_BUMP(&(seen->frequency), count);
+            ATOMIC_BUMP(&(line->count.total), count);
+            return freq;
+         }
+         i = (i + 1 == arr->cap) ? 0 : i + 1;
+      }
+      if (probes == arr->cap)
+         atomicGrow(ht, arr, 1);
+      else
+         atomicWait(ht);
+   }
+}
+
+HTEntry atomicLookUp(HashTable *ht, void *data, unsigned hash) {
+   AtomicSlots *arr;
+   HashNode *seen;
+   HTEntry entry;
+   unsigned i, probes;
+   for (;;) {
+      arr = ATOMIC_LOAD(&(ht->atomic->current));
+      i = REDUCE(&(arr->reduce), hash);
+      for (probes = 0; probes < arr->cap; probes++) {
+         if ((seen = ATOMIC_LOAD(arr->slots + i)) == NULL)
+            return invalidEntry();
+         if (seen == MOVED)
+            break;
+         if (seen->hash == hash && MATCHES(ht->match, seen->data, data)) {
+            entry.data = seen->data;
+            entry.frequency = ATOMIC_PEEK(&(seen->frequency));
+            return entry;
+         }
+         i = (i + 1 == arr->cap) ? 0 : i + 1;
+      }
+      if (probes == arr->cap)
+         return invalidEntry();
+      atomicWait(ht);
+   }
+}
+
+unsigned atomicCapacity(HashTable *ht) {
+   return ATOMIC_LOAD(&(ht->atomic->current))->cap;
+}
+
+int atomicSum(HashTable *ht, int unique) {
+   /* a snapshot of moving counts while other threads add */
+   int i, sum = 0;
+   for (i = 0; i < ATOMIC_LINES; i++)
+      sum += unique ? ATOMIC_PEEK(&(ht->atomic->lines[i].count.unique)) :
+         ATOMIC_PEEK(&(ht->atomic->lines[i].count.total));
+   return sum;
+}
+
+int atomicNext(HashTable *ht, unsigned *index, unsigned end, HashNode *node,
+   unsigned *high) {
+   /* the first entry from slot *index on, 0 when there is none before end */
+   AtomicSlots *arr = ht->atomic->current;
+   for (; *index < end; (*index)++) {
+      if (arr->slots[*index] == NULL)
+         continue;
+      *node = *(arr->slots[(*index)++]);
+      *high = 0;
+      return 1;
+   }
+   return 0;
+}
+
+HTMetrics atomicMetrics(HashTable *ht) {
+   /* with plain linear probing a chain is a cluster, a run of occupied
+    * slots between two empty ones */
+   AtomicSlots *arr = ht->atomic->current;
+   unsigned i, run = 0;
+   HTMetrics met;
+   met.numberOfChains = 0;
+   met.maxChainLength = 0;
+   met.avgChainLength = 0;
+   for (i = 0; i <= arr->cap; i++) {
+      if (i < arr->cap && arr->slots[i] != NULL) {
+         run++;
+         continue;
+      }
+      if (run) {
+         met.numberOfChains++;
+         if (run > met.maxChainLength)
+            met.maxChainLength = run;
+      }
+      run = 0;
+   }
+   /* a cluster wrapping around the end was counted as two */
+   if (arr->slots[0] != NULL && arr->slots[arr->cap - 1] != NULL &&
+      met.numberOfChains > 1)
+      met.numberOfChains--;
+   if (met.numberOfChains)
+      met.avgChainLength = (double)htUniqueEntries(ht) / met.numberOfChains;
+   return met;
+}
@@ -0,0 +1,53 @@
+#ifndef HASHATOMIC_H
+#define HASHATOMIC_H
+
+#include <pthread.h>
+
+#include "hashfuncs.h"
+
+/* counter lines of an HT_ATOMIC table, picked by the top bits of the
+ * mixed hash */
+#define ATOMIC_LINES 64
+#define ATOMIC_LINE_SHIFT 26
+
+/* one generation of the slot array; a slot holds NULL, a node or MOVED
+ * once a resize has copied past it. limit is the unique count at which the
+ * generation is replaced, retired links the generations replaced so far */
+typedef struct atomicSlots
+{
+   HashNode **slots;
+   unsigned cap;
+   unsigned limit;
+   HashReducer reduce;
+   struct atomicSlots *retired;
+}  AtomicSlots;
+
+typedef union
+{
+   struct
+   {
+      int unique;
+      int total;
+   }  count;
+   char line[128];
+}  AtomicLine;
+
+typedef struct atomicTable
+{
+   AtomicSlots *current;
+   pthread_mutex_t grow;
+   AtomicLine lines[ATOMIC_LINES];
+}  AtomicTable;
+
+AtomicTable* atomicCreate(HashTable *ht, unsigned cap);
+void atomicDestroy(HashTable *ht, int keepData);
+unsigned atomicAdd(HashTable *ht, void *data, unsigned hash,
+   unsigned count);
+HTEntry atomicLookUp(HashTable *ht, void *data, unsigned hash);
+unsigned atomicCapacity(HashTable *ht);
+int atomicSum(HashTable *ht, int unique);
+int atomicNext(HashTable *ht, unsigned *index, unsigned end, HashNode *node,
+   unsigned *high);
+HTMetrics atomicMetrics(HashTable *ht);
+
+#endif
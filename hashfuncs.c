@@ -1,8 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "hashTable.h"
 #include "hashfuncs.h"
+#include "hashopen.h"
+#include "hashatomic.h"
 #include "hashmacros.h"
 
 HTEntry invalidEntry() {
@@ -12,78 +15,252 @@ HTEntry invalidEntry() {
    return entry;
 }
 
-int initNode(HTEntry entry, HashNode *node,
-   int cap, unsigned (*hash)(const void *data)) {
-   /* pass in empty node to be initialized, returns hash value */
-   node->entry = entry;
-   node->next = NULL;
-   node->listSize = 1;
-   return hashData(entry.data, cap, *hash);
+HTEntry nodeEntry(HashNode *node) {
+   HTEntry entry;
+   entry.data = node->data;
+   entry.frequency = node->frequency;
+   return entry;
+}
+
+void reducerInit(HashReducer *red, unsigned cap) {
+   /* recomputed whenever a table changes capacity */
+   red->cap = cap;
+   red->mask = cap - 1;
+   red->mul = 0;
+#if ULONG_MAX > 0xFFFFFFFFUL
+   if (cap & (cap - 1))
+      red->mul = ULONG_MAX / cap + 1;
+#endif
 }
 
-unsigned hashData(void *data, int capacity,
-   unsigned (*hash)(const void *data)) {
-   return (*hash)(data) % capacity;
+unsigned hashData(HashTable *ht, void *data, unsigned *high) {
+   /* returns the low 32 bits of the hash, high gets the rest (0 unless the
+    * table has a 64 bit hash) */
+   unsigned long wide;
+   *high = 0;
+   if (ht->opts->hash64 == NULL)
+      return (*(ht->funcs->hash))(data);
+   wide = (*(ht->opts->hash64))(data);
+#if ULONG_MAX > 0xFFFFFFFFUL
+   *high = (unsigned)(wide >> 32);
+#endif
+   return (unsigned)wide;
 }
 
-int addToHashArr(HashNode **hashArr, int h, HashNode *newNode,
-   int (*compare)(const void *data1, const void *data2)) {
-   int i = 0, isDuplicate = 0;
-   if(hashArr[h] == NULL) {
-      hashArr[h] = malloc(sizeof(HashNode));
-      CHECK_ALLOC(hashArr[h]);
-      hashArr[h][0] = *newNode;
-      return 1;
+int addToHashArr(HashArena *arena, HashBucket **hashArr, int h,
+   HashNode *newNode, unsigned high, int wide, const HashMatch *match) {
+   HashNode *found;
+   /* check if entry is a duplicate within the bucket; returns the
+    * frequency it ends up with, the new node's own when it is added */
+   if (hashArr[h] != NULL && (found = findInBucket(hashArr[h],
+      newNode->data, newNode->hash, high, wide, match)) != NULL) {
+      return found->frequency += newNode->frequency;
    }
-   /* check if entry is a duplicate within linkedList; also get last index */
-   if((isDuplicate = checkDuplicate(&i, hashArr[h], newNode, (*compare)))) {
-      return isDuplicate;
+   appendToHashArr(arena, hashArr, h, newNode, high, wide);
+   return newNode->frequency;
+}
+
+static unsigned bucketClass(unsigned capacity) {
+   /* bucket capacities are powers of two, one arena size class each */
+   unsigned sizeClass = 0;
+   while (capacity >>= 1)
+      sizeClass++;
+   return sizeClass;
+}
+
+static HashBucket* allocBucket(HashArena *arena, unsigned capacity,
+   int wide) {
+   /* a table is either wide or not, so a size class keeps one size */
+   HashBucket *bucket = arenaAlloc(arena, bucketClass(capacity),
+      sizeof(HashBucket) + capacity * (sizeof(HashNode) +
+      (wide ? sizeof(unsigned) : 0)));
+   bucket->size = 0;
+   bucket->capacity = capacity;
+   return bucket;
+}
+
+void freeBucket(HashArena *arena, HashBucket *bucket) {
+   arenaFree(arena, bucket, bucketClass(bucket->capacity));
+}
+
+void appendToHashArr(HashArena *arena, HashBucket **hashArr, int h,
+   HashNode *newNode, unsigned high, int wide) {
+   /* newNode must not already be in the bucket; capacity doubles so long
+    * chains are copied O(1) times per node */
+   HashBucket *bucket = hashArr[h];
+   if (bucket == NULL) {
+      bucket = allocBucket(arena, 1, wide);
+   } else if (bucket->size == bucket->capacity) {
+      bucket = allocBucket(arena, hashArr[h]->capacity * 2, wide);
+      memcpy(BUCKET_NODES(bucket), BUCKET_NODES(hashArr[h]),
+         hashArr[h]->size * sizeof(HashNode));
+      if (wide)
+         memcpy(BUCKET_HIGHS(bucket), BUCKET_HIGHS(hashArr[h]),
+            hashArr[h]->size * sizeof(unsigned));
+      bucket->size = hashArr[h]->size;
+      freeBucket(arena, hashArr[h]);
    }
-   /* improve for cpu performance; currently using linear allocation */
-   hashArr[h][0].listSize += 1;
-   hashArr[h] = realloc(hashArr[h], hashArr[h][0].listSize * sizeof(HashNode));
-   CHECK_ALLOC(hashArr[h]);
-   hashArr[h][i] = *newNode;
-   return 1;
+   BUCKET_NODES(bucket)[bucket->size] = *newNode;
+   if (wide)
+      BUCKET_HIGHS(bucket)[bucket->size] = high;
+   bucket->size += 1;
+   hashArr[h] = bucket;
 }
 
-int checkDuplicate(int *i, HashNode *list, HashNode *newNode, 
-   int (*compare)(const void *data1, const void *data2)) {
-   while (*i < list[0].listSize) {
-      if ((*compare)(list[*i].entry.data, newNode->entry.data) == 0) {
-         list[*i].entry.frequency += 1;
-         return list[*i].entry.frequency;
-      }
-      *i += 1;
+HashNode* findInBucket(HashBucket *bucket, void *data, unsigned hash,
+   unsigned high, int wide, const HashMatch *match) {
+   unsigned i;
+   HashNode *nodes = BUCKET_NODES(bucket);
+   for (i = 0; i < bucket->size; i++) {
+      /* only entries with the same full hash can be equal */
+      if (nodes[i].hash == hash && (!wide || BUCKET_HIGHS(bucket)[i] == high)
+         && MATCHES(match, nodes[i].data, data))
+         return &nodes[i];
    }
-   return 0; 
+   return NULL;
 }
 
-void freeListData(HashNode *linkedList, void (*destroy)(const void *data)) {
-   int i;
-   for (i = linkedList[0].listSize - 1; i >= 0; i--) {
-      if ((*destroy) != NULL)
-         (*destroy)(linkedList[i].entry.data);
-      else
-         free(linkedList[i].entry.data);
+void removeNode(HashArena *arena, HashBucket **slot, HashNode *node,
+   int wide) {
+   /* the bucket's last node takes the removed one's place; a bucket a
+    * quarter full moves to one half the size and an empty one is freed */
+   HashBucket *bucket = *slot, *smaller;
+   HashNode *nodes = BUCKET_NODES(bucket);
+   unsigned i = node - nodes, last = --(bucket->size);
+   nodes[i] = nodes[last];
+   if (wide)
+      BUCKET_HIGHS(bucket)[i] = BUCKET_HIGHS(bucket)[last];
+   if (bucket->size == 0) {
+      freeBucket(arena, bucket);
+      *slot = NULL;
+   } else if (bucket->size * 4 <= bucket->capacity) {
+      smaller = allocBucket(arena, bucket->capacity / 2, wide);
+      memcpy(BUCKET_NODES(smaller), nodes, bucket->size * sizeof(HashNode));
+      if (wide)
+         memcpy(BUCKET_HIGHS(smaller), BUCKET_HIGHS(bucket),
+            bucket->size * sizeof(unsigned));
+      smaller->size = bucket->size;
+      freeBucket(arena, bucket);
+      *slot = smaller;
+   }
+}
+
+unsigned walkSize(HashTable *ht) {
+   /* positions a walk goes through: the slots, or the buckets of the new
+    * array followed by those of the old one */
+   if (ht->opts->engine != HT_CHAINED)
+      return htCapacity(ht);
+   return htCapacity(ht) + (ht->oldArr != NULL ? ht->nums[OLD_CAP] : 0);
+}
+
+int walkNodes(HashTable *ht, unsigned *index, unsigned *node, unsigned end,
+   HashNode *out, unsigned *high) {
+   /* the first entry from node *node at position *index on with its hash,
+    * 0 when there is none before end */
+   HashBucket *bucket;
+   unsigned cap = htCapacity(ht);
+   if (ht->opts->engine == HT_OPEN)
+      return openNext(ht, index, end, out, high);
+   if (ht->opts->engine == HT_ATOMIC)
+      return atomicNext(ht, index, end, out, high);
+   for (; *index < end; (*index)++, *node = 0) {
+      bucket = (*index < cap) ? ht->hashArr[*index] :
+         ht->oldArr[*index - cap];
+      if (bucket != NULL && *node < bucket->size) {
+         *out = BUCKET_NODES(bucket)[*node];
+         *high = (ht->opts->hash64 != NULL) ? BUCKET_HIGHS(bucket)[*node] : 0;
+         (*node)++;
+         return 1;
+      }
    }
-   free(linkedList);
+   return 0;
 }
 
-void rehashValues(HashTable* ht, HashNode** newHashArr, int newCap) {
-   int h, i, newHash;
-   HashNode newNode;
-   /* iterate through old hash table to add vals */
+int walkNext(HashTable *ht, unsigned *index, unsigned *node, unsigned end,
+   HTEntry *entry) {
+   HashNode found;
+   unsigned high;
+   if (!walkNodes(ht, index, node, end, &found, &high))
+      return 0;
+   *entry = nodeEntry(&found);
+   return 1;
+}
+
+static int equalSlice(const void *data, const void *slice) {
+   /* FNEqual between a stored string and a HashSlice; strncmp stops at
+    * the string's nul, which the slice never contains, so the string is
+    * never read past it */
+   const HashSlice *sl = slice;
+   return strncmp(data, sl->key, sl->len) == 0 &&
+      ((const char*)data)[sl->len] == 0;
+}
+
+const HashMatch sliceMatch = {NULL, equalSlice};
+
+char* sliceCopy(HashSlice *slice) {
+   char *copy = malloc(slice->len + 1);
+   CHECK_ALLOC(copy);
+   memcpy(copy, slice->key, slice->len);
+   copy[slice->len] = 0;
+   return copy;
+}
+
+void freeData(void *data, void (*destroy)(const void *data)) {
+   /* destroy only frees sub-allocations, the data itself is always freed */
+   if (destroy != NULL)
+      (*destroy)(data);
+   free(data);
+}
+
+void freeListData(HashBucket *bucket, void (*destroy)(const void *data)) {
+   /* only the user's data, the bucket itself belongs to the table's arena */
+   unsigned i;
+   for (i = 0; i < bucket->size; i++)
+      freeData(BUCKET_NODES(bucket)[i].data, destroy);
+}
+
+static void copyBucket(HashArena *arena, HashBucket *bucket,
+   HashBucket **newHashArr, HashReducer *red, int wide) {
+   unsigned i;
+   HashNode *nodes = BUCKET_NODES(bucket);
+   for (i = 0; i < bucket->size; i++)
+      appendToHashArr(arena, newHashArr, REDUCE(red, nodes[i].hash),
+         &nodes[i], wide ? BUCKET_HIGHS(bucket)[i] : 0, wide);
+}
+
+void moveBucket(HashArena *arena, HashBucket *bucket, HashBucket **newHashArr,
+   HashReducer *red, int wide) {
+   copyBucket(arena, bucket, newHashArr, red, wide);
+   freeBucket(arena, bucket);
+}
+
+void rehashValues(HashTable* ht, HashBucket** newHashArr, int newCap) {
+   unsigned h;
+   HashReducer red;
+   HashArena *old = NULL;
+   /* iterate through old hash table to add vals; entries are already unique
+    * and carry their hash so neither the user's hash nor compare is called.
+    * Each old bucket goes back to the arena as soon as it is moved so the
+    * new buckets mostly reuse its memory */
+   reducerInit(&red, newCap);
+   /* except when rehashing down: the buckets are copied into a fresh arena
+    * and the old one, sized for the larger table, goes back to malloc.
+    * Buckets of a thread safe table belong to the stripes' arenas */
+   if ((unsigned)newCap < htCapacity(ht) && ht->stripes == NULL) {
+      old = ht->arena;
+      ht->arena = arenaCreate();
+   }
    for (h = 0; h < htCapacity(ht); h++) {
-      if(ht->hashArr[h] == NULL)
+      if (ht->hashArr[h] == NULL)
          continue;
-      for (i = 0; i < ht->hashArr[h][0].listSize; i++) {
-         newHash = initNode(ht->hashArr[h][i].entry, &newNode,
-            newCap, ht->funcs->hash);
-         addToHashArr(newHashArr, newHash, &newNode, ht->funcs->compare);
-      }
-      free(ht->hashArr[h]);
+      if (old != NULL)
+         copyBucket(ht->arena, ht->hashArr[h], newHashArr, &red,
+            ht->opts->hash64 != NULL);
+      else
+         moveBucket(ht->arena, ht->hashArr[h], newHashArr, &red,
+            ht->opts->hash64 != NULL);
    }
+   if (old != NULL)
+      arenaDestroy(old);
    free(ht->hashArr);
 }
-
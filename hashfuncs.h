@@ -1,19 +1,131 @@
 #ifndef HASHFUNCS_H
-#define HASHFUNS_H
+#define HASHFUNCS_H
+
+#include <limits.h>
 
 #include "hashTable.h"
+#include "hashTableExt.h"
+#include "hasharena.h"
+
+#define NUMS_SIZE 7
+
+#define NUM_SIZES 0
+#define CAP  1
+#define TOT_ENTRS 2
+#define UNI_ENTRS 3
+#define CUR_SIZE_INDEX 4
+#define OLD_CAP 5
+#define MIGRATE_INDEX 6
+
+/* old buckets a thread of a parallel rehash gets at the least */
+#define REHASH_MIN_BUCKETS 16384
+
+/* maps a full hash to an index below cap without dividing: a mask when cap
+ * is a power of two, otherwise Lemire's fastmod with mul = 2^64 / cap + 1.
+ * Needs a 64 bit unsigned long, elsewhere REDUCE falls back to % */
+typedef struct
+{
+   unsigned long mul;
+   unsigned mask;
+   unsigned cap;
+}  HashReducer;
+
+#if ULONG_MAX > 0xFFFFFFFFUL
+#if defined(__SIZEOF_INT128__)
+#define MULHI(_A, _B) ((unsigned long)(__extension__ \
+   ((unsigned __int128)(_A) * (_B) >> 64)))
+#else
+/* high word of a 64 by 32 bit product */
+#define MULHI(_A, _B) ((((_A) >> 32) * (_B) + \
+   (((_A) & 0xFFFFFFFFUL) * (_B) >> 32)) >> 32)
+#endif
+#define REDUCE(_RED, _HASH) ((_RED)->mul ? \
+   (unsigned)MULHI((_RED)->mul * (_HASH), (_RED)->cap) : \
+   (_HASH) & (_RED)->mask)
+#else
+#define REDUCE(_RED, _HASH) ((_HASH) % (_RED)->cap)
+#endif
+
+/* a key given as bytes by htAddSlice/htLookUpSlice, the table stores it
+ * as a nul-terminated copy */
+typedef struct
+{
+   const char *key;
+   size_t len;
+}  HashSlice;
+
+/* how scans decide that two data are the same: equal when it is set,
+ * otherwise compare returning 0 */
+typedef struct
+{
+   int (*compare)(const void *data1, const void *data2);
+   FNEqual equal;
+}  HashMatch;
 
-typedef struct node
+#define MATCHES(_MATCH, _DATA1, _DATA2) (((_MATCH)->equal != NULL) ? \
+   (*((_MATCH)->equal))((_DATA1), (_DATA2)) : \
+   (*((_MATCH)->compare))((_DATA1), (_DATA2)) == 0)
+
+#if defined(__GNUC__)
+#define PREFETCH(_ADDR) __builtin_prefetch(_ADDR)
+#else
+#define PREFETCH(_ADDR) ((void)0)
+#endif
+
+/* entry record of both engines; an open addressing slot is empty when
+ * data is NULL */
+typedef struct
 {
-   HTEntry entry;
-   struct node *next;
-   unsigned listSize;
+   void *data;
+   unsigned frequency;
+   unsigned hash;
 }  HashNode;
 
+/* header of a chained bucket, its nodes follow it in the same allocation */
+typedef struct
+{
+   unsigned size;
+   unsigned capacity;
+}  HashBucket;
+
+#define BUCKET_NODES(_BUCKET) ((HashNode*)((_BUCKET) + 1))
+
+/* tables with a 64 bit hash keep the high halves after the nodes */
+#define BUCKET_HIGHS(_BUCKET) \
+   ((unsigned*)(BUCKET_NODES(_BUCKET) + (_BUCKET)->capacity))
+
+/* slots of the open addressing engine, either one array of nodes or, for
+ * HT_SOA, the data, hashes and freqs arrays; ctrl is NULL unless tagged and
+ * highs NULL unless the table has a 64 bit hash. Inline keys take width
+ * bytes of keys per slot and their length in klen */
+typedef struct
+{
+   HashNode *nodes;
+   void **data;
+   unsigned *hashes;
+   unsigned *freqs;
+   unsigned *highs;
+   unsigned char *ctrl;
+   unsigned char *keys;
+   unsigned char *klen;
+   unsigned width;
+   unsigned cap;
+   HashReducer reduce;
+}  SlotArray;
+
 typedef struct
 {
-   HashNode **hashArr;
+   HashBucket **hashArr;
+   HashBucket **oldArr;
+   SlotArray *slots;
+   HashArena *arena;
+   struct stripeSet *stripes;
+   struct atomicTable *atomic;
+   HashReducer *reduce;
+   HashReducer *oldReduce;
+   HashMatch *match;
    HTFunctions *funcs;
+   HTOptions *opts;
    unsigned *sizes;
    float rehashLoadFactor;
    int *nums;
@@ -22,15 +134,35 @@ typedef struct
 
 
 HTEntry invalidEntry();
-int initNode(HTEntry entry, HashNode *node,
-   int cap, unsigned (*hash)(const void *data));
-int getLastIndex(HTEntry* newEntry, int *h, int* isUnique, HashNode** hashArr);
-int addToHashArr(HashNode **hashArr, int h, HashNode *newNode,
-   int (*compare)(const void *data1, const void *data2));
-int checkDuplicate(int *i, HashNode *list, HashNode *newNode, 
-   int (*compare)(const void *data1, const void *data2));
-unsigned hashData(void *data, int capacity, unsigned (*hash)(const void *data));
-void rehashValues(HashTable* ht, HashNode** newHashArr, int newCap);
-void freeListData(HashNode *linkedList, void (*destroy)(const void *data));
+HTEntry nodeEntry(HashNode *node);
+void reducerInit(HashReducer *red, unsigned cap);
+unsigned hashData(HashTable *ht, void *data, unsigned *high);
+int addToHashArr(HashArena *arena, HashBucket **hashArr, int h,
+   HashNode *newNode, unsigned high, int wide, const HashMatch *match);
+void appendToHashArr(HashArena *arena, HashBucket **hashArr, int h,
+   HashNode *newNode, unsigned high, int wide);
+void freeBucket(HashArena *arena, HashBucket *bucket);
+void removeNode(HashArena *arena, HashBucket **slot, HashNode *node,
+   int wide);
+void moveBucket(HashArena *arena, HashBucket *bucket, HashBucket **newHashArr,
+   HashReducer *red, int wide);
+HashNode* findInBucket(HashBucket *bucket, void *data, unsigned hash,
+   unsigned high, int wide, const HashMatch *match);
+void rehashValues(HashTable* ht, HashBucket** newHashArr, int newCap);
+void rehashParallel(HashTable *ht, HashBucket **newHashArr, unsigned newCap);
+unsigned growthStep(HashTable *ht, unsigned long cap);
+unsigned nextCapacity(HashTable *ht);
+unsigned addHashed(HashTable *ht, void *data, unsigned hash, unsigned high,
+   unsigned count);
+void destroyTable(HashTable *ht, int keepData);
+unsigned walkSize(HashTable *ht);
+int walkNodes(HashTable *ht, unsigned *index, unsigned *node, unsigned end,
+   HashNode *out, unsigned *high);
+int walkNext(HashTable *ht, unsigned *index, unsigned *node, unsigned end,
+   HTEntry *entry);
+extern const HashMatch sliceMatch;
+char* sliceCopy(HashSlice *slice);
+void freeData(void *data, void (*destroy)(const void *data));
+void freeListData(HashBucket *bucket, void (*destroy)(const void *data));
 
 #endif
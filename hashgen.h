@@ -0,0 +1,141 @@
+/* Compile time generated hash tables. HT_DEFINE(Name, KeyType, hashFn,
+ * equalFn) emits a table type Name holding KeyType keys by value together
+ * with their frequencies, and static functions working on it:
+ *
+ *    void NameInit(Name *table, unsigned capacity)
+ *    void NameDestroy(Name *table)
+ *    unsigned NameAdd(Name *table, KeyType key)
+ *    unsigned NameLookUp(Name *table, KeyType key)
+ *    NameEntry* NameFind(Name *table, KeyType key)
+ *
+ * HT_DEFINE is used at file scope, without a trailing semicolon.
+ *
+ * NameAdd and NameLookUp return frequencies like htAdd and htLookUp (0 when
+ * absent), table->unique and table->total count entries like
+ * htUniqueEntries and htTotalEntries.
+ *
+ * hashFn(key) must give an unsigned hash and equalFn(key1, key2) nonzero for
+ * equal keys. Both are called directly, so macros and static functions are
+ * inlined into every probe. Capacities are powers of two indexed by the low
+ * bits of the hash, use a mixing hash such as htGenMix32 for integers.
+ *
+ * The table is linear probing over one array of entries; an entry with a
+ * frequency of 0 is empty. It doubles once three quarters are used. Nothing
+ * is allocated per key and keys are never freed, so KeyType should be a
+ * value type: integers or fixed size structs.
+ */
+#ifndef HASHGEN_H
+#define HASHGEN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hashmacros.h"
+
+#if defined(__GNUC__)
+#define HT_GEN_UNUSED __attribute__((unused))
+#else
+#define HT_GEN_UNUSED
+#endif
+
+/* equalFn for keys that compare with == */
+#define HT_GEN_EQUAL(_KEY1, _KEY2) ((_KEY1) == (_KEY2))
+
+/* lowbias32, see htMix32 */
+static HT_GEN_UNUSED unsigned htGenMix32(unsigned value)
+{
+   value ^= value >> 16;
+   value *= 0x7FEB352DU;
+   value ^= value >> 15;
+   value *= 0x846CA68BU;
+   return value ^ (value >> 16);
+}
+
+#define HT_DEFINE(_NAME, _KEY, _HASH, _EQUAL) \
+\
+typedef struct \
+{ \
+   _KEY key; \
+   unsigned frequency; \
+}  _NAME##Entry; \
+\
+typedef struct \
+{ \
+   _NAME##Entry *slots; \
+   unsigned cap; \
+   unsigned unique; \
+   unsigned total; \
+}  _NAME; \
+\
+static HT_GEN_UNUSED void _NAME##Init(_NAME *table, unsigned capacity) \
+{ \
+   /* rounded up to a power of two */ \
+   table->cap = 8; \
+   while (table->cap < capacity) \
+      table->cap <<= 1; \
+   table->slots = calloc(table->cap, sizeof(_NAME##Entry)); \
+   CHECK_ALLOC(table->slots); \
+   table->unique = 0; \
+   table->total = 0; \
+} \
+\
+static HT_GEN_UNUSED void _NAME##Destroy(_NAME *table) \
+{ \
+   free(table->slots); \
+   table->slots = NULL; \
+} \
+\
+static HT_GEN_UNUSED _NAME##Entry* _NAME##Find(_NAME *table, _KEY key) \
+{ \
+   unsigned mask = table->cap - 1, i = (_HASH(key)) & mask; \
+   for (; table->slots[i].frequency != 0; i = (i + 1) & mask) { \
+      if (_EQUAL(table->slots[i].key, key)) \
+         return &(table->slots[i]); \
+   } \
+   return NULL; \
+} \
+\
+static HT_GEN_UNUSED void _NAME##Grow(_NAME *table) \
+{ \
+   unsigned i, j, mask, oldCap = table->cap; \
+   _NAME##Entry *old = table->slots; \
+   table->cap *= 2; \
+   mask = table->cap - 1; \
+   table->slots = calloc(table->cap, sizeof(_NAME##Entry)); \
+   CHECK_ALLOC(table->slots); \
+   for (i = 0; i < oldCap; i++) { \
+      if (old[i].frequency == 0) \
+         continue; \
+      for (j = (_HASH(old[i].key)) & mask; table->slots[j].frequency != 0; \
+         j = (j + 1) & mask) \
+         ; \
+      table->slots[j] = old[i]; \
+   } \
+   free(old); \
+} \
+\
+static HT_GEN_UNUSED unsigned _NAME##Add(_NAME *table, _KEY key) \
+{ \
+   unsigned i, mask; \
+   if (4 * (table->unique + 1) > 3 * table->cap) \
+      _NAME##Grow(table); \
+   mask = table->cap - 1; \
+   table->total++; \
+   for (i = (_HASH(key)) & mask; table->slots[i].frequency != 0; \
+      i = (i + 1) & mask) { \
+      if (_EQUAL(table->slots[i].key, key)) \
+         return ++(table->slots[i].frequency); \
+   } \
+   table->slots[i].key = key; \
+   table->slots[i].frequency = 1; \
+   table->unique++; \
+   return 1; \
+} \
+\
+static HT_GEN_UNUSED unsigned _NAME##LookUp(_NAME *table, _KEY key) \
+{ \
+   _NAME##Entry *entry = _NAME##Find(table, key); \
+   return (entry != NULL) ? entry->frequency : 0; \
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include <limits.h>
+#include <string.h>
+
+#include "hashlib.h"
+
+/* htHashBytes follows MurmurHash3: each word is mixed on its own and folded
+ * into the state, a partial last word is read into a zeroed word and the
+ * length goes into the finalizer so trailing zero bytes still count. Words
+ * are loaded with memcpy, which compilers turn into a plain unaligned load.
+ * With a 64 bit unsigned long the x64 mixing constants are used on 8 byte
+ * words, otherwise the 32 bit version on 4 byte words.
+ */
+
+#define ROTL32(_X, _R) (((_X) << (_R)) | ((_X) >> (32 - (_R))))
+
+#if ULONG_MAX > 0xFFFFFFFFUL
+
+#define ROTL64(_X, _R) (((_X) << (_R)) | ((_X) >> (64 - (_R))))
+#define C1 0x87C37B91114253D5UL
+#define C2 0x4CF5AD432745937FUL
+
+static unsigned long mixWord(unsigned long k) {
+   k *= C1;
+   k = ROTL64(k, 31);
+   return k * C2;
+}
+
+static unsigned long fmix64(unsigned long h) {
+   h ^= h >> 33;
+   h *= 0xFF51AFD7ED558CCDUL;
+   h ^= h >> 33;
+   h *= 0xC4CEB9FE1A85EC53UL;
+   return h ^ (h >> 33);
+}
+
+unsigned long htHashBytes64(const void *data, size_t len, unsigned seed) {
+   const unsigned char *bytes = data;
+   size_t left = len;
+   unsigned long h = seed, k;
+   for (; left >= sizeof(k); left -= sizeof(k), bytes += sizeof(k)) {
+      memcpy(&k, bytes, sizeof(k));
+      h ^= mixWord(k);
+      h = ROTL64(h, 27) * 5 + 0x52DCE729;
+   }
+   if (left) {
+      k = 0;
+      memcpy(&k, bytes, left);
+      h ^= mixWord(k);
+   }
+   return fmix64(h ^ len);
+}
+
+unsigned htHashBytes(const void *data, size_t len, unsigned seed) {
+   return (unsigned)htHashBytes64(data, len, seed);
+}
+
+unsigned htMixLong(unsigned long value) {
+   value = fmix64(value);
+   return (unsigned)(value ^ (value >> 32));
+}
+
+#else
+
+#define C1 0xCC9E2D51U
+#define C2 0x1B873593U
+
+static unsigned mixWord(unsigned k) {
+   k *= C1;
+   k = ROTL32(k, 15);
+   return k * C2;
+}
+
+unsigned htHashBytes(const void *data, size_t len, unsigned seed) {
+   const unsigned char *bytes = data;
+   size_t left = len;
+   unsigned h = seed, k;
+   for (; left >= sizeof(k); left -= sizeof(k), bytes += sizeof(k)) {
+      memcpy(&k, bytes, sizeof(k));
+      h ^= mixWord(k);
+      h = ROTL32(h, 13) * 5 + 0xE6546B64U;
+   }
+   if (left) {
+      k = 0;
+      memcpy(&k, bytes, left);
+      h ^= mixWord(k);
+   }
+   h ^= (unsigned)len;
+   h ^= h >> 16;
+   h *= 0x85EBCA6BU;
+   h ^= h >> 13;
+   h *= 0xC2B2AE35U;
+   return h ^ (h >> 16);
+}
+
+unsigned long htHashBytes64(const void *data, size_t len, unsigned seed) {
+   return htHashBytes(data, len, seed);
+}
+
+unsigned htMixLong(unsigned long value) {
+   return htMix32(value);
+}
+
+#endif
+
+unsigned htMix32(unsigned value) {
+   /* Chris Wellons' lowbias32 */
+   value ^= value >> 16;
+   value *= 0x7FEB352DU;
+   value ^= value >> 15;
+   value *= 0x846CA68BU;
+   return value ^ (value >> 16);
+}
+
+unsigned htHashSlice(const void *key, size_t len) {
+   return htHashBytes(key, len, 0);
+}
+
+unsigned htHashString(const void *data) {
+   return htHashBytes(data, strlen(data), 0);
+}
+
+unsigned long htHashString64(const void *data) {
+   return htHashBytes64(data, strlen(data), 0);
+}
+
+unsigned htHashUnsigned(const void *data) {
+   return htMix32(*(const unsigned*)data);
+}
+
+unsigned htHashULong(const void *data) {
+   return htMixLong(*(const unsigned long*)data);
+}
+
+unsigned htHashPointer(const void *data) {
+   /* the low bits of an address are mostly alignment zeros */
+   return htMixLong((unsigned long)data);
+}
+
+int htEqualString(const void *data1, const void *data2) {
+   return strcmp(data1, data2) == 0;
+}
+
+int htEqualUnsigned(const void *data1, const void *data2) {
+   return *(const unsigned*)data1 == *(const unsigned*)data2;
+}
+
+int htEqualULong(const void *data1, const void *data2) {
+   return *(const unsigned long*)data1 == *(const unsigned long*)data2;
+}
+
+int htCompareString(const void *data1, const void *data2) {
+   return strcmp(data1, data2);
+}
+
+int htCompareUnsigned(const void *data1, const void *data2) {
+   unsigned x = *(const unsigned*)data1, y = *(const unsigned*)data2;
+   return (x > y) - (x < y);
+}
+
+int htCompareULong(const void *data1, const void *data2) {
+   unsigned long x = *(const unsigned long*)data1;
+   unsigned long y = *(const unsigned long*)data2;
+   return (x > y) - (x < y);
+}
+
+int htComparePointer(const void *data1, const void *data2) {
+   /* ordered by address so it also works as a qsort comparator */
+   unsigned long x = (unsigned long)data1, y = (unsigned long)data2;
+   return (x > y) - (x < y);
+}
@@ -0,0 +1,67 @@
+/* Ready made hash and compare functions for HTFunctions. Every hash returns
+ * the raw 32 bit value, the table reduces it to a bucket index.
+ */
+#ifndef HASHLIB_H
+#define HASHLIB_H
+
+#include <stdlib.h>
+
+/* Description: Hashes len bytes starting at data, a word at a time.
+ *
+ * Notes:
+ *    1. data needs no particular alignment.
+ *    2. Different seeds give independent hash functions.
+ *
+ * Return: The 32 bit hash of the bytes.
+ */
+unsigned htHashBytes(const void *data, size_t len, unsigned seed);
+
+/* Description: htHashBytes with seed 0, the FNHashBytes that matches
+ *    htHashString.
+ */
+unsigned htHashSlice(const void *key, size_t len);
+
+/* Description: htHashBytes with all the bits of unsigned long, for
+ *    HTOptions.hash64 (through htHashString64).
+ */
+unsigned long htHashBytes64(const void *data, size_t len, unsigned seed);
+
+/* Description: Mixes all bits of value into every bit of the result. A
+ *    bijection, so distinct values never collide before reduction.
+ */
+unsigned htMix32(unsigned value);
+
+/* Description: Like htMix32 for unsigned long, folded to 32 bits.
+ */
+unsigned htMixLong(unsigned long value);
+
+/* FNHash functions.
+ *
+ *    htHashString: data is a nul-terminated string, pairs with
+ *       htCompareString.
+ *    htHashString64: FNHash64 version of htHashString.
+ *    htHashUnsigned: data points to an unsigned, pairs with
+ *       htCompareUnsigned.
+ *    htHashULong: data points to an unsigned long, pairs with
+ *       htCompareULong.
+ *    htHashPointer: data itself is the key, its address is hashed and never
+ *       dereferenced. Pairs with htComparePointer.
+ */
+unsigned htHashString(const void *data);
+unsigned long htHashString64(const void *data);
+unsigned htHashUnsigned(const void *data);
+unsigned htHashULong(const void *data);
+unsigned htHashPointer(const void *data);
+
+/* FNEqual functions matching the hashes above, for HTOptions.equal. */
+int htEqualString(const void *data1, const void *data2);
+int htEqualUnsigned(const void *data1, const void *data2);
+int htEqualULong(const void *data1, const void *data2);
+
+/* FNCompare functions matching the hashes above. */
+int htCompareString(const void *data1, const void *data2);
+int htCompareUnsigned(const void *data1, const void *data2);
+int htCompareULong(const void *data1, const void *data2);
+int htComparePointer(const void *data1, const void *data2);
+
+#endif
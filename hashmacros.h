@@ -9,4 +9,32 @@
    }\
 }
 
+/* Atomic access for the thread safe tables: LOAD/STORE acquire and
+ * release, PEEK/POKE relaxed, BUMP a relaxed fetch and add and CAS a
+ * compare and swap that leaves the value found in *_EXPECTED when it fails.
+ * Without GCC style builtins they fall back to plain accesses, which are
+ * only correct for single threaded use.
+ */
+#if defined(__GNUC__)
+#define ATOMIC_LOAD(_PTR) __atomic_load_n((_PTR), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(_PTR, _VALUE) \
+   __atomic_store_n((_PTR), (_VALUE), __ATOMIC_RELEASE)
+#define ATOMIC_PEEK(_PTR) __atomic_load_n((_PTR), __ATOMIC_RELAXED)
+#define ATOMIC_POKE(_PTR, _VALUE) \
+   __atomic_store_n((_PTR), (_VALUE), __ATOMIC_RELAXED)
+#define ATOMIC_BUMP(_PTR, _VALUE) \
+   __atomic_add_fetch((_PTR), (_VALUE), __ATOMIC_RELAXED)
+#define ATOMIC_CAS(_PTR, _EXPECTED, _VALUE) \
+   __atomic_compare_exchange_n((_PTR), (_EXPECTED), (_VALUE), 0, \
+   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#define ATOMIC_LOAD(_PTR) (*(_PTR))
+#define ATOMIC_STORE(_PTR, _VALUE) (*(_PTR) = (_VALUE))
+#define ATOMIC_PEEK(_PTR) (*(_PTR))
+#define ATOMIC_POKE(_PTR, _VALUE) (*(_PTR) = (_VALUE))
+#define ATOMIC_BUMP(_PTR, _VALUE) (*(_PTR) += (_VALUE))
+#define ATOMIC_CAS(_PTR, _EXPECTED, _VALUE) ((*(_PTR) == *(_EXPECTED)) ? \
+   (*(_PTR) = (_VALUE), 1) : (*(_EXPECTED) = *(_PTR), 0))
+#endif
+
 #endif
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "hashTable.h"
+#include "hashfuncs.h"
+#include "hashmacros.h"
+
+/* Merging tables: every entry of the source is added to the destination
+ * with the hash and frequency it already has, so the destination only ever
+ * compares data landing on the same hash and never calls FNHash. The
+ * parallel version merges disjoint pairs of tables on separate threads,
+ * halving the number of tables each round.
+ */
+
+/* one merge of an htMergeParallel round */
+typedef struct
+{
+   void *dst;
+   void *src;
+}  MergeTask;
+
+void htMerge(void *dstTable, void *srcTable)
+{
+   HashTable *dst = dstTable, *src = srcTable;
+   unsigned index = 0, node = 0, end = walkSize(src), high;
+   HashNode found;
+
+   assert(dst != src);
+   assert(dst->funcs->hash == src->funcs->hash &&
+      dst->opts->hash64 == src->opts->hash64);
+   /* dst frees what it is handed the way src would have */
+   assert(dst->funcs->destroy == src->funcs->destroy);
+   assert(src->opts->inlineKeyWidth == 0);
+
+   if (dst->stripes == NULL && dst->atomic == NULL)
+      htReserve(dst, htUniqueEntries(dst) > htUniqueEntries(src) ?
+         htUniqueEntries(dst) : htUniqueEntries(src));
+   while (walkNodes(src, &index, &node, end, &found, &high)) {
+      /* the frequency comes back unchanged only when dst kept the data */
+      if (addHashed(dst, found.data, found.hash, high, found.frequency) !=
+         found.frequency)
+         freeData(found.data, src->funcs->destroy);
+   }
+   destroyTable(src, 1);
+}
+
+static void* mergeTask(void *arg)
+{
+   MergeTask *task = arg;
+   htMerge(task->dst, task->src);
+   return NULL;
+}
+
+void* htMergeParallel(void *tables[], unsigned count)
+{
+   unsigned i, t, n, stride;
+   void **live, *merged;
+   MergeTask *tasks;
+   pthread_t *ids;
+   int *started;
+
+   assert(count > 0);
+   live = malloc(count * sizeof(void*));
+   tasks = malloc(count * sizeof(MergeTask));
+   ids = malloc(count * sizeof(pthread_t));
+   started = malloc(count * sizeof(int));
+   CHECK_ALLOC(live);
+   CHECK_ALLOC(tasks);
+   CHECK_ALLOC(ids);
+   CHECK_ALLOC(started);
+   for (i = 0; i < count; i++)
+      live[i] = tables[i];
+
+   /* each round merges live[i + stride] and live[i] into live[i] */
+   for (stride = 1; stride < count; stride *= 2) {
+      for (n = 0, i = 0; i + stride < count; i += 2 * stride, n++) {
+         /* moving the smaller table adds fewer entries */
+         if (htUniqueEntries(live[i]) >= htUniqueEntries(live[i + stride])) {
+            tasks[n].dst = live[i];
+            tasks[n].src = live[i + stride];
+         } else {
+            tasks[n].dst = live[i + stride];
+            tasks[n].src = live[i];
+         }
+         live[i] = tasks[n].dst;
+      }
+      for (t = 1; t < n; t++)
+         started[t] = pthread_create(ids + t, NULL, mergeTask,
+            tasks + t) == 0;
+      mergeTask(tasks);
+      for (t = 1; t < n; t++) {
+         if (started[t])
+            pthread_join(ids[t], NULL);
+         else
+            mergeTask(tasks + t);
+      }
+   }
+
+   merged = live[0];
+   free(live);
+   free(tasks);
+   free(ids);
+   free(started);
+   return merged;
+}
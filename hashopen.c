@@ -0,0 +1,549 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashTable.h"
+#include "hashfuncs.h"
+#include "hashopen.h"
+#include "hashmacros.h"
+
+/* Open addressing engine: Robin Hood linear probing over one slot array.
+ * Every entry keeps its full hash so probe distances and rehashing never
+ * call the user's hash function again.
+ *
+ * Tagged tables also keep a control byte per slot, EMPTY or the top 7 bits
+ * of the hash. The array has GROUP_WIDTH extra bytes mirroring the start of
+ * the table so a group can be loaded at any slot without wrapping.
+ *
+ * HT_SOA tables keep data pointers, hashes and frequencies in three arrays
+ * instead of one array of HashNode, so scans read only the fields they use.
+ *
+ * Tables with a 64 bit hash keep its high halves in highs and take their
+ * tags from them instead of from the low half, which picks the slot.
+ *
+ * An inline key lives in the slot's keys bytes and its data pointer is
+ * INLINE_DATA, so a NULL data pointer still means an empty slot. Moving such
+ * a slot carries its key bytes along in a SlotCopy.
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GROUP_WIDTH 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GROUP_WIDTH 16
+#else
+#define GROUP_WIDTH 16
+#endif
+
+#define EMPTY 0x80
+#define TAG(_HASH) ((unsigned char)((_HASH) >> 25))
+
+static char inlineMark;
+#define INLINE_DATA ((void*)&inlineMark)
+
+typedef struct
+{
+   HashNode node;
+   unsigned high;
+   unsigned keyLen;
+   unsigned char key[HT_MAX_INLINE_KEY];
+}  SlotCopy;
+
+/* what a lookup compares slots against; for slice keys data is the
+ * HashSlice and inline keys compare cmpLen bytes of key plus the nul */
+typedef struct
+{
+   void *data;
+   HashSlice *slice;
+   const void *key;
+   unsigned hash;
+   unsigned high;
+   size_t keyLen;
+   size_t cmpLen;
+   const HashMatch *match;
+}  Probe;
+
+static unsigned nextSlot(unsigned i, unsigned cap) {
+   return (i + 1 == cap) ? 0 : i + 1;
+}
+
+SlotArray* slotsCreate(unsigned cap, HTOptions *opts) {
+   SlotArray *sa = malloc(sizeof(SlotArray));
+   CHECK_ALLOC(sa);
+   sa->cap = cap;
+   reducerInit(&(sa->reduce), cap);
+   sa->nodes = NULL;
+   sa->data = NULL;
+   sa->highs = NULL;
+   sa->ctrl = NULL;
+   sa->keys = NULL;
+   sa->klen = NULL;
+   sa->width = opts->inlineKeyWidth;
+   if (opts->layout == HT_SOA) {
+      /* one allocation: cap data pointers, then cap hashes, then cap
+       * frequencies */
+      sa->data = calloc(cap, sizeof(void*) + 2 * sizeof(unsigned));
+      CHECK_ALLOC(sa->data);
+      sa->hashes = (unsigned*)(sa->data + cap);
+      sa->freqs = sa->hashes + cap;
+   } else {
+      sa->nodes = calloc(cap, sizeof(HashNode));
+      CHECK_ALLOC(sa->nodes);
+   }
+   if (opts->hash64 != NULL) {
+      sa->highs = malloc(cap * sizeof(unsigned));
+      CHECK_ALLOC(sa->highs);
+   }
+   if (opts->tagged) {
+      sa->ctrl = malloc(cap + GROUP_WIDTH);
+      CHECK_ALLOC(sa->ctrl);
+      memset(sa->ctrl, EMPTY, cap + GROUP_WIDTH);
+   }
+   if (sa->width) {
+      sa->keys = malloc((size_t)cap * sa->width);
+      sa->klen = calloc(cap, 1);
+      CHECK_ALLOC(sa->keys);
+      CHECK_ALLOC(sa->klen);
+   }
+   return sa;
+}
+
+void slotsDestroy(SlotArray *sa) {
+   free(sa->nodes);
+   free(sa->data);
+   free(sa->highs);
+   free(sa->ctrl);
+   free(sa->keys);
+   free(sa->klen);
+   free(sa);
+}
+
+static void* slotRaw(SlotArray *sa, unsigned i) {
+   /* NULL for empty slots, INLINE_DATA for inline keys */
+   return (sa->nodes != NULL) ? sa->nodes[i].data : sa->data[i];
+}
+
+static void* slotData(SlotArray *sa, unsigned i) {
+   void *data = slotRaw(sa, i);
+   return (data == INLINE_DATA) ? sa->keys + (size_t)i * sa->width : data;
+}
+
+static unsigned slotHash(SlotArray *sa, unsigned i) {
+   return (sa->nodes != NULL) ? sa->nodes[i].hash : sa->hashes[i];
+}
+
+static unsigned* slotFreq(SlotArray *sa, unsigned i) {
+   return (sa->nodes != NULL) ? &(sa->nodes[i].frequency) : &(sa->freqs[i]);
+}
+
+static void getSlot(SlotArray *sa, unsigned i, SlotCopy *copy) {
+   if (sa->nodes != NULL) {
+      copy->node = sa->nodes[i];
+   } else {
+      copy->node.data = sa->data[i];
+      copy->node.hash = sa->hashes[i];
+      copy->node.frequency = sa->freqs[i];
+   }
+   copy->high = (sa->highs != NULL) ? sa->highs[i] : 0;
+   copy->keyLen = 0;
+   if (copy->node.data == INLINE_DATA) {
+      copy->keyLen = sa->klen[i];
+      memcpy(copy->key, sa->keys + (size_t)i * sa->width, copy->keyLen);
+   }
+}
+
+static void setCtrl(unsigned char *ctrl, unsigned cap, unsigned i,
+   unsigned char tag) {
+   /* tables smaller than a group are mirrored more than once */
+   for (; i < cap + GROUP_WIDTH; i += cap)
+      ctrl[i] = tag;
+}
+
+static void setSlot(SlotArray *sa, unsigned i, SlotCopy *copy) {
+   if (sa->nodes != NULL) {
+      sa->nodes[i] = copy->node;
+   } else {
+      sa->data[i] = copy->node.data;
+      sa->hashes[i] = copy->node.hash;
+      sa->freqs[i] = copy->node.frequency;
+   }
+   if (sa->highs != NULL)
+      sa->highs[i] = copy->high;
+   if (sa->ctrl != NULL)
+      setCtrl(sa->ctrl, sa->cap, i,
+         TAG((sa->highs != NULL) ? copy->high : copy->node.hash));
+   if (sa->klen != NULL) {
+      sa->klen[i] = copy->keyLen;
+      memcpy(sa->keys + (size_t)i * sa->width, copy->key, copy->keyLen);
+   }
+}
+
+static void probeInit(HashTable *ht, Probe *probe, void *data, unsigned hash,
+   unsigned high) {
+   probe->data = data;
+   probe->slice = NULL;
+   probe->key = data;
+   probe->hash = hash;
+   probe->high = high;
+   /* 0 unless the table stores inline keys */
+   probe->keyLen = ht->slots->width ? (*(ht->opts->keySize))(data) : 0;
+   probe->cmpLen = probe->keyLen;
+   probe->match = ht->match;
+}
+
+static void sliceProbeInit(HashTable *ht, Probe *probe, HashSlice *slice) {
+   probe->data = slice;
+   probe->slice = slice;
+   probe->key = slice->key;
+   probe->hash = (*(ht->opts->hashBytes))(slice->key, slice->len);
+   probe->high = 0;
+   /* stored keys are nul-terminated strings */
+   probe->keyLen = ht->slots->width ? slice->len + 1 : 0;
+   probe->cmpLen = slice->len;
+   probe->match = &sliceMatch;
+}
+
+static int slotMatches(HashTable *ht, unsigned i, Probe *probe) {
+   SlotArray *sa = ht->slots;
+   void *raw;
+   if (slotHash(sa, i) != probe->hash ||
+      (sa->highs != NULL && sa->highs[i] != probe->high))
+      return 0;
+   if ((raw = slotRaw(sa, i)) == INLINE_DATA)
+      return sa->klen[i] == probe->keyLen && memcmp(sa->keys +
+         (size_t)i * sa->width, probe->key, probe->cmpLen) == 0;
+   /* keys that fit are always stored inline */
+   if (probe->keyLen && probe->keyLen <= sa->width)
+      return 0;
+   return MATCHES(probe->match, raw, probe->data);
+}
+
+static unsigned long matchGroup(const unsigned char *group, unsigned char tag,
+   unsigned long *empty) {
+   /* bit j of the result is set when group[j] holds tag, bit j of empty
+    * when group[j] is EMPTY */
+#if defined(__AVX2__)
+   __m256i ctrl = _mm256_loadu_si256((const __m256i*)group);
+   *empty = (unsigned)_mm256_movemask_epi8(ctrl);
+   return (unsigned)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8((char)tag)));
+#elif defined(__SSE2__)
+   __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+   *empty = (unsigned)_mm_movemask_epi8(ctrl);
+   return (unsigned)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)tag)));
+#else
+   int j;
+   unsigned long match = 0;
+   *empty = 0;
+   for (j = 0; j < GROUP_WIDTH; j++) {
+      if (group[j] == tag)
+         match |= 1UL << j;
+      else if (group[j] == EMPTY)
+         *empty |= 1UL << j;
+   }
+   return match;
+#endif
+}
+
+static unsigned lowestBit(unsigned long bits) {
+#if defined(__GNUC__)
+   return __builtin_ctzl(bits);
+#else
+   unsigned n = 0;
+   for (; !(bits & 1); bits >>= 1)
+      n++;
+   return n;
+#endif
+}
+
+static unsigned taggedFind(HashTable *ht, Probe *probe) {
+   SlotArray *sa = ht->slots;
+   unsigned cap = sa->cap, i = REDUCE(&(sa->reduce), probe->hash), scanned;
+   unsigned slot;
+   unsigned char tag = TAG((sa->highs != NULL) ? probe->high : probe->hash);
+   unsigned long match, empty, stop;
+   for (scanned = 0; scanned < cap; scanned += GROUP_WIDTH) {
+      match = matchGroup(sa->ctrl + i, tag, &empty);
+      /* only tags before the first empty slot belong to the probe run */
+      stop = empty & (~empty + 1);
+      if (stop)
+         match &= stop - 1;
+      while (match) {
+         for (slot = i + lowestBit(match); slot >= cap; slot -= cap)
+            ;
+         if (slotMatches(ht, slot, probe))
+            return slot;
+         match &= match - 1;
+      }
+      if (empty)
+         return cap;
+      for (i += GROUP_WIDTH; i >= cap; i -= cap)
+         ;
+   }
+   return cap;
+}
+
+static unsigned probeDistance(SlotArray *sa, unsigned i) {
+   unsigned home = REDUCE(&(sa->reduce), slotHash(sa, i));
+   return (i >= home) ? i - home : i + sa->cap - home;
+}
+
+static unsigned openFind(HashTable *ht, Probe *probe) {
+   /* returns the slot holding the data or the capacity when it is absent */
+   SlotArray *sa = ht->slots;
+   unsigned cap = sa->cap, i = REDUCE(&(sa->reduce), probe->hash), dist = 0;
+   if (sa->ctrl != NULL)
+      return taggedFind(ht, probe);
+   /* Robin Hood ordering: once the resident is closer to home than we are
+    * the data cannot be further along the run */
+   while (slotRaw(sa, i) != NULL && dist <= probeDistance(sa, i)) {
+      if (slotMatches(ht, i, probe))
+         return i;
+      i = nextSlot(i, cap);
+      dist++;
+   }
+   return cap;
+}
+
+static void openPlace(SlotArray *sa, SlotCopy *slot) {
+   /* slot must not already be in the table and there must be a free slot;
+    * slot is used as scratch space for the entries it displaces */
+   unsigned i = REDUCE(&(sa->reduce), slot->node.hash), dist = 0, resDist;
+   SlotCopy spare, *tmp, *displaced = &spare;
+   while (slotRaw(sa, i) != NULL) {
+      if ((resDist = probeDistance(sa, i)) < dist) {
+         getSlot(sa, i, displaced);
+         setSlot(sa, i, slot);
+         tmp = slot;
+         slot = displaced;
+         displaced = tmp;
+         dist = resDist;
+      }
+      i = nextSlot(i, sa->cap);
+      dist++;
+   }
+   setSlot(sa, i, slot);
+}
+
+static unsigned openAddProbe(HashTable *ht, Probe *probe, unsigned count) {
+   /* new data is stored inline if it fits, new slices are copied */
+   SlotCopy slot;
+   unsigned i;
+   if ((i = openFind(ht, probe)) != ht->slots->cap)
+      return *slotFreq(ht->slots, i) += count;
+   slot.node.data = probe->data;
+   slot.node.hash = probe->hash;
+   slot.node.frequency = count;
+   slot.high = probe->high;
+   slot.keyLen = 0;
+   if (probe->keyLen && probe->keyLen <= ht->slots->width) {
+      /* the table keeps its own copy of short keys */
+      slot.node.data = INLINE_DATA;
+      slot.keyLen = probe->keyLen;
+      memcpy(slot.key, probe->key, probe->cmpLen);
+      memset(slot.key + probe->cmpLen, 0, probe->keyLen - probe->cmpLen);
+      if (probe->slice == NULL)
+         free(probe->data);
+   } else if (probe->slice != NULL) {
+      slot.node.data = sliceCopy(probe->slice);
+   }
+   openPlace(ht->slots, &slot);
+   return count;
+}
+
+unsigned openAdd(HashTable *ht, void *data, unsigned hash, unsigned high,
+   unsigned count) {
+   Probe probe;
+   probeInit(ht, &probe, data, hash, high);
+   return openAddProbe(ht, &probe, count);
+}
+
+unsigned openAddSlice(HashTable *ht, HashSlice *slice) {
+   Probe probe;
+   sliceProbeInit(ht, &probe, slice);
+   return openAddProbe(ht, &probe, 1);
+}
+
+static HTEntry probeEntry(HashTable *ht, Probe *probe) {
+   HTEntry entry;
+   unsigned i;
+   if ((i = openFind(ht, probe)) == ht->slots->cap)
+      return invalidEntry();
+   entry.data = slotData(ht->slots, i);
+   entry.frequency = *slotFreq(ht->slots, i);
+   return entry;
+}
+
+HTEntry openLookUp(HashTable *ht, void *data, unsigned hash,
+   unsigned high) {
+   Probe probe;
+   probeInit(ht, &probe, data, hash, high);
+   return probeEntry(ht, &probe);
+}
+
+HTEntry openLookUpSlice(HashTable *ht, HashSlice *slice) {
+   Probe probe;
+   sliceProbeInit(ht, &probe, slice);
+   return probeEntry(ht, &probe);
+}
+
+static void clearSlot(SlotArray *sa, unsigned i) {
+   if (sa->nodes != NULL)
+      sa->nodes[i].data = NULL;
+   else
+      sa->data[i] = NULL;
+   if (sa->ctrl != NULL)
+      setCtrl(sa->ctrl, sa->cap, i, EMPTY);
+   if (sa->klen != NULL)
+      sa->klen[i] = 0;
+}
+
+static void shiftBack(SlotArray *sa, unsigned i) {
+   /* backward shift deletion: the entries after the emptied slot i move
+    * one slot closer to home until one is already home, leaving the table
+    * as if the removed entry had never been added */
+   SlotCopy slot;
+   unsigned next = nextSlot(i, sa->cap);
+   while (slotRaw(sa, next) != NULL && probeDistance(sa, next) != 0) {
+      getSlot(sa, next, &slot);
+      setSlot(sa, i, &slot);
+      i = next;
+      next = nextSlot(i, sa->cap);
+   }
+   clearSlot(sa, i);
+}
+
+unsigned openRemove(HashTable *ht, void *data, unsigned hash, unsigned high,
+   unsigned count) {
+   /* see removeHashed */
+   SlotArray *sa = ht->slots;
+   Probe probe;
+   unsigned i, *freq, old;
+   void *stored;
+   probeInit(ht, &probe, data, hash, high);
+   if ((i = openFind(ht, &probe)) == sa->cap)
+      return 0;
+   freq = slotFreq(sa, i);
+   if ((old = *freq) > count) {
+      *freq -= count;
+      return old;
+   }
+   stored = slotRaw(sa, i);
+   shiftBack(sa, i);
+   if (stored != INLINE_DATA)
+      freeData(stored, ht->funcs->destroy);
+   return old;
+}
+
+void openPrefetch(HashTable *ht, unsigned hash) {
+   /* the first thing a probe from this hash reads */
+   SlotArray *sa = ht->slots;
+   unsigned i = REDUCE(&(sa->reduce), hash);
+   if (sa->ctrl != NULL)
+      PREFETCH(sa->ctrl + i);
+   else if (sa->nodes != NULL)
+      PREFETCH(sa->nodes + i);
+   else
+      PREFETCH(sa->hashes + i);
+}
+
+void openRehash(HashTable *ht, unsigned newCap) {
+   unsigned i;
+   SlotCopy slot;
+   SlotArray *newSlots = slotsCreate(newCap, ht->opts);
+   for (i = 0; i < ht->slots->cap; i++) {
+      if (slotRaw(ht->slots, i) == NULL)
+         continue;
+      getSlot(ht->slots, i, &slot);
+      openPlace(newSlots, &slot);
+   }
+   slotsDestroy(ht->slots);
+   ht->slots = newSlots;
+}
+
+int openNext(HashTable *ht, unsigned *index, unsigned end, HashNode *node,
+   unsigned *high) {
+   /* the first entry from slot *index on, 0 when there is none before end */
+   SlotArray *sa = ht->slots;
+   for (; *index < end; (*index)++) {
+      if (slotRaw(sa, *index) == NULL)
+         continue;
+      node->data = slotData(sa, *index);
+      node->frequency = *slotFreq(sa, *index);
+      node->hash = slotHash(sa, *index);
+      *high = (sa->highs != NULL) ? sa->highs[*index] : 0;
+      (*index)++;
+      return 1;
+   }
+   return 0;
+}
+
+unsigned openToArray(HashTable *ht, HTEntry *entries) {
+   /* htToArray's bulk path, returns the number of entries stored */
+   unsigned i, n = 0;
+   SlotArray *sa = ht->slots;
+   /* one loop per layout so the SoA scan streams the data array and only
+    * touches frequencies of occupied slots */
+   if (sa->nodes == NULL) {
+      for (i = 0; i < sa->cap; i++) {
+         if (sa->data[i] == NULL)
+            continue;
+         entries[n].data = slotData(sa, i);
+         entries[n++].frequency = sa->freqs[i];
+      }
+   } else {
+      for (i = 0; i < sa->cap; i++) {
+         if (sa->nodes[i].data == NULL)
+            continue;
+         entries[n].data = slotData(sa, i);
+         entries[n++].frequency = sa->nodes[i].frequency;
+      }
+   }
+   return n;
+}
+
+HTMetrics openMetrics(HashTable *ht) {
+   /* a chain is the run of entries sharing a home slot; Robin Hood keeps
+    * such entries next to each other so one pass starting after an empty
+    * slot counts them */
+   SlotArray *sa = ht->slots;
+   unsigned n, i = 0, cap = sa->cap, home, runHome = 0, runLength = 0;
+   HTMetrics met;
+   met.numberOfChains = 0;
+   met.maxChainLength = 0;
+   met.avgChainLength = 0;
+   while (i < cap && slotRaw(sa, i) != NULL)
+      i++;
+   i = (i == cap) ? 0 : i;
+   for (n = 0; n < cap; n++, i = nextSlot(i, cap)) {
+      if (slotRaw(sa, i) == NULL) {
+         runLength = 0;
+         continue;
+      }
+      home = REDUCE(&(sa->reduce), slotHash(sa, i));
+      if (runLength == 0 || home != runHome) {
+         met.numberOfChains++;
+         runHome = home;
+         runLength = 0;
+      }
+      runLength++;
+      if (runLength > met.maxChainLength)
+         met.maxChainLength = runLength;
+   }
+   if (met.numberOfChains)
+      met.avgChainLength = (double)htUniqueEntries(ht) / met.numberOfChains;
+   return met;
+}
+
+void openDestroy(HashTable *ht, int keepData) {
+   unsigned i;
+   void *data;
+   /* inline keys were freed when they were added */
+   for (i = 0; i < ht->slots->cap && !keepData; i++) {
+      if ((data = slotRaw(ht->slots, i)) != NULL && data != INLINE_DATA)
+         freeData(data, ht->funcs->destroy);
+   }
+   slotsDestroy(ht->slots);
+}
@@ -0,0 +1,24 @@
+#ifndef HASHOPEN_H
+#define HASHOPEN_H
+
+#include "hashTable.h"
+#include "hashfuncs.h"
+
+unsigned openAdd(HashTable *ht, void *data, unsigned hash, unsigned high,
+   unsigned count);
+HTEntry openLookUp(HashTable *ht, void *data, unsigned hash, unsigned high);
+unsigned openRemove(HashTable *ht, void *data, unsigned hash, unsigned high,
+   unsigned count);
+void openPrefetch(HashTable *ht, unsigned hash);
+unsigned openAddSlice(HashTable *ht, HashSlice *slice);
+HTEntry openLookUpSlice(HashTable *ht, HashSlice *slice);
+SlotArray* slotsCreate(unsigned cap, HTOptions *opts);
+void slotsDestroy(SlotArray *sa);
+void openRehash(HashTable *ht, unsigned newCap);
+int openNext(HashTable *ht, unsigned *index, unsigned end, HashNode *node,
+   unsigned *high);
+unsigned openToArray(HashTable *ht, HTEntry *entries);
+HTMetrics openMetrics(HashTable *ht);
+void openDestroy(HashTable *ht, int keepData);
+
+#endif
@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "hashTable.h"
+#include "hashfuncs.h"
+#include "hashmacros.h"
+
+/* Parallel rehash of chained tables. The old bucket array is split into
+ * ranges, one per thread, and each thread moves the buckets of its range
+ * into the new array. Entries of one old bucket land all over the new one,
+ * so appends are guarded by a spin lock byte per new bucket; two threads
+ * rarely want the same bucket at once. Every thread allocates from and
+ * frees to an arena of its own, which the table adopts once all are done.
+ */
+
+/* one thread's share of rehashParallel */
+typedef struct
+{
+   HashTable *ht;
+   HashBucket **newHashArr;
+   unsigned char *locks;
+   HashReducer *red;
+   HashArena *arena;
+   unsigned begin;
+   unsigned end;
+}  RehashTask;
+
+static void lockBucket(unsigned char *lock) {
+   unsigned char open = 0;
+   while (!ATOMIC_CAS(lock, &open, 1)) {
+      /* the holder may be waiting for a cpu */
+      sched_yield();
+      open = 0;
+   }
+}
+
+static void* rehashTask(void *arg) {
+   RehashTask *task = arg;
+   HashBucket *bucket;
+   HashNode *nodes;
+   unsigned h, i, to;
+   int wide = task->ht->opts->hash64 != NULL;
+   for (h = task->begin; h < task->end; h++) {
+      if ((bucket = task->ht->hashArr[h]) == NULL)
+         continue;
+      nodes = BUCKET_NODES(bucket);
+      for (i = 0; i < bucket->size; i++) {
+         to = REDUCE(task->red, nodes[i].hash);
+         lockBucket(task->locks + to);
+         appendToHashArr(task->arena, task->newHashArr, to, nodes + i,
+            wide ? BUCKET_HIGHS(bucket)[i] : 0, wide);
+         ATOMIC_STORE(task->locks + to, 0);
+      }
+      freeBucket(task->arena, bucket);
+   }
+   return NULL;
+}
+
+void rehashParallel(HashTable *ht, HashBucket **newHashArr, unsigned newCap) {
+   /* rehashValues split between up to opts->rehashThreads threads, none of
+    * them with fewer than REHASH_MIN_BUCKETS old buckets */
+   unsigned t, cap = htCapacity(ht), threads = ht->opts->rehashThreads;
+   unsigned chunk, extra;
+   unsigned char *locks;
+   RehashTask *tasks;
+   pthread_t *ids;
+   int *started;
+   HashReducer red;
+
+   if (threads > cap / REHASH_MIN_BUCKETS)
+      threads = cap / REHASH_MIN_BUCKETS;
+   if (threads <= 1) {
+      rehashValues(ht, newHashArr, newCap);
+      return;
+   }
+
+   locks = calloc(newCap, sizeof(unsigned char));
+   tasks = malloc(threads * sizeof(RehashTask));
+   ids = malloc(threads * sizeof(pthread_t));
+   started = malloc(threads * sizeof(int));
+   CHECK_ALLOC(locks);
+   CHECK_ALLOC(tasks);
+   CHECK_ALLOC(ids);
+   CHECK_ALLOC(started);
+   reducerInit(&red, newCap);
+   chunk = cap / threads;
+   extra = cap % threads;
+   for (t = 0; t < threads; t++) {
+      tasks[t].ht = ht;
+      tasks[t].newHashArr = newHashArr;
+      tasks[t].locks = locks;
+      tasks[t].red = &red;
+      tasks[t].arena = arenaCreate();
+      tasks[t].begin = t * chunk + (t < extra ? t : extra);
+      tasks[t].end = tasks[t].begin + chunk + (t < extra);
+   }
+
+   /* the calling thread takes the first range, and any range a thread
+    * could not be started for */
+   for (t = 1; t < threads; t++)
+      started[t] = pthread_create(ids + t, NULL, rehashTask, tasks + t) == 0;
+   rehashTask(tasks);
+   for (t = 1; t < threads; t++) {
+      if (started[t])
+         pthread_join(ids[t], NULL);
+      else
+         rehashTask(tasks + t);
+   }
+
+   for (t = 0; t < threads; t++)
+      arenaAdopt(ht->arena, tasks[t].arena);
+   free(ht->hashArr);
+   free(locks);
+   free(tasks);
+   free(ids);
+   free(started);
+}
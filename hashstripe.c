@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hashTable.h"
+#include "hashstripe.h"
+#include "hashmacros.h"
+
+/* Thread safe chained tables. Bucket h is guarded by the mutex of stripe
+ * h % count, so calls on different stripes never wait for each other.
+ * Entries are counted per stripe and summed on demand, so no counter is
+ * shared between stripes either.
+ *
+ * Rehashing needs every stripe: the thread that finds its stripe crowded
+ * takes all the locks in order, checks the real load and resizes. Which
+ * stripe a hash belongs to depends on the capacity, so a call first picks
+ * its stripe from the epoch it read and, once it holds the lock, checks
+ * that no exclusive section changed the capacity meanwhile. Every such
+ * section ends a new epoch; when the epoch moved the call unlocks and
+ * picks again.
+ */
+
+#define STRIPE(_SET, _S) (&((_SET)->lines[_S].stripe))
+
+static void publish(StripeSet *set, HashReducer *reduce) {
+   ATOMIC_POKE(&(set->guess.mul), reduce->mul);
+   ATOMIC_POKE(&(set->guess.mask), reduce->mask);
+   ATOMIC_POKE(&(set->guess.cap), reduce->cap);
+}
+
+StripeSet* stripesCreate(unsigned count, HashReducer *reduce) {
+   unsigned s;
+   StripeSet *set = malloc(sizeof(StripeSet));
+   CHECK_ALLOC(set);
+   set->lines = malloc(count * sizeof(StripeLine));
+   CHECK_ALLOC(set->lines);
+   set->count = count;
+   set->epoch = 0;
+   publish(set, reduce);
+   for (s = 0; s < count; s++) {
+      if (pthread_mutex_init(&(STRIPE(set, s)->lock), NULL) != 0) {
+         fprintf(stderr, "ERROR: mutex init: %s: %d\n", __FILE__, __LINE__);
+         exit(EXIT_FAILURE);
+      }
+      STRIPE(set, s)->arena = arenaCreate();
+      STRIPE(set, s)->unique = 0;
+      STRIPE(set, s)->total = 0;
+   }
+   return set;
+}
+
+void stripesDestroy(StripeSet *set) {
+   unsigned s;
+   for (s = 0; s < set->count; s++) {
+      pthread_mutex_destroy(&(STRIPE(set, s)->lock));
+      arenaDestroy(STRIPE(set, s)->arena);
+   }
+   free(set->lines);
+   free(set);
+}
+
+unsigned stripeLock(HashTable *ht, unsigned hash) {
+   /* returns the locked stripe of hash; the guess may be read while a
+    * rehash rewrites it, the epoch check throws such a stripe away */
+   StripeSet *set = ht->stripes;
+   HashReducer red;
+   unsigned epoch, s;
+   for (;;) {
+      epoch = ATOMIC_LOAD(&(set->epoch));
+      red.mul = ATOMIC_PEEK(&(set->guess.mul));
+      red.mask = ATOMIC_PEEK(&(set->guess.mask));
+      red.cap = ATOMIC_PEEK(&(set->guess.cap));
+      s = REDUCE(&red, hash) % set->count;
+      pthread_mutex_lock(&(STRIPE(set, s)->lock));
+      if (ATOMIC_LOAD(&(set->epoch)) == epoch)
+         return s;
+      pthread_mutex_unlock(&(STRIPE(set, s)->lock));
+   }
+}
+
+void stripeUnlock(HashTable *ht, unsigned s) {
+   pthread_mutex_unlock(&(STRIPE(ht->stripes, s)->lock));
+}
+
+void stripesLockAll(HashTable *ht) {
+   /* always in the same order, so two threads never deadlock */
+   unsigned s;
+   for (s = 0; s < ht->stripes->count; s++)
+      pthread_mutex_lock(&(STRIPE(ht->stripes, s)->lock));
+}
+
+void stripesUnlockAll(HashTable *ht) {
+   /* stripes picked under an unchanged capacity are still right */
+   unsigned s;
+   if (ATOMIC_PEEK(&(ht->stripes->guess.cap)) != ht->reduce->cap) {
+      publish(ht->stripes, ht->reduce);
+      ATOMIC_STORE(&(ht->stripes->epoch), ht->stripes->epoch + 1);
+   }
+   for (s = ht->stripes->count; s > 0; s--)
+      pthread_mutex_unlock(&(STRIPE(ht->stripes, s - 1)->lock));
+}
+
+HashArena* stripeArena(HashTable *ht, unsigned h) {
+   /* where bucket h is allocated and freed */
+   if (ht->stripes == NULL)
+      return ht->arena;
+   return STRIPE(ht->stripes, h % ht->stripes->count)->arena;
+}
+
+void stripeCount(HashTable *ht, unsigned s, int unique, int total) {
+   /* atomic only so htUniqueEntries can read it without the lock */
+   ATOMIC_BUMP(&(STRIPE(ht->stripes, s)->unique), unique);
+   ATOMIC_BUMP(&(STRIPE(ht->stripes, s)->total), total);
+}
+
+int stripeSum(HashTable *ht, int unique) {
+   /* exact under all the locks, a snapshot of moving counts otherwise */
+   unsigned s;
+   int sum = 0;
+   for (s = 0; s < ht->stripes->count; s++)
+      sum += unique ? ATOMIC_PEEK(&(STRIPE(ht->stripes, s)->unique)) :
+         ATOMIC_PEEK(&(STRIPE(ht->stripes, s)->total));
+   return sum;
+}
+
+int stripeCrowded(HashTable *ht, unsigned s) {
+   /* called with stripe s locked: whether the table would be over the
+    * load factor if every stripe held as many entries as this one, and
+    * has a larger capacity to rehash to */
+   return *(ht->rehashFactor) != 1.0 && nextCapacity(ht) != 0 &&
+      (double)STRIPE(ht->stripes, s)->unique * ht->stripes->count >
+      *(ht->rehashFactor) * htCapacity(ht);
+}
@@ -0,0 +1,49 @@
+#ifndef HASHSTRIPE_H
+#define HASHSTRIPE_H
+
+#include <pthread.h>
+
+#include "hashfuncs.h"
+
+/* bytes a stripe is padded to so two stripes never share a cache line */
+#define STRIPE_LINE 128
+
+/* one lock stripe of a thread safe table: bucket h belongs to stripe
+ * h % count, which guards it and allocates it. The counts are of the calls
+ * that went through the stripe, only their sums mean anything */
+typedef struct
+{
+   pthread_mutex_t lock;
+   HashArena *arena;
+   int unique;
+   int total;
+}  Stripe;
+
+typedef union
+{
+   Stripe stripe;
+   char line[STRIPE_LINE];
+}  StripeLine;
+
+/* guess is the table's reducer as of the last epoch, read without a lock
+ * to pick a stripe */
+typedef struct stripeSet
+{
+   StripeLine *lines;
+   unsigned count;
+   unsigned epoch;
+   HashReducer guess;
+}  StripeSet;
+
+StripeSet* stripesCreate(unsigned count, HashReducer *reduce);
+void stripesDestroy(StripeSet *set);
+unsigned stripeLock(HashTable *ht, unsigned hash);
+void stripeUnlock(HashTable *ht, unsigned s);
+void stripesLockAll(HashTable *ht);
+void stripesUnlockAll(HashTable *ht);
+HashArena* stripeArena(HashTable *ht, unsigned h);
+void stripeCount(HashTable *ht, unsigned s, int unique, int total);
+int stripeSum(HashTable *ht, int unique);
+int stripeCrowded(HashTable *ht, unsigned s);
+
+#endif
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "hashTable.h"
+#include "hashfuncs.h"
+#include "hashmacros.h"
+
+/* Top-K selection: a min-heap of at most k entries ordered by frequency
+ * holds the best entries seen so far, its root being the one a new entry
+ * has to beat. The parallel version walks disjoint ranges of the table into
+ * one heap per thread and merges those heaps at the end.
+ */
+
+typedef struct
+{
+   HTEntry *heap;
+   unsigned k;
+   unsigned size;
+}  TopHeap;
+
+/* one thread's share of htTopKParallel */
+typedef struct
+{
+   HashTable *ht;
+   unsigned begin;
+   unsigned end;
+   TopHeap top;
+}  TopTask;
+
+static void siftDown(HTEntry *heap, unsigned size, unsigned i) {
+   HTEntry moving = heap[i];
+   unsigned child;
+   while ((child = 2 * i + 1) < size) {
+      if (child + 1 < size &&
+         heap[child + 1].frequency < heap[child].frequency)
+         child++;
+      if (heap[child].frequency >= moving.frequency)
+         break;
+      heap[i] = heap[child];
+      i = child;
+   }
+   heap[i] = moving;
+}
+
+static void heapOffer(TopHeap *top, HTEntry entry) {
+   unsigned i;
+   if (top->size < top->k) {
+      for (i = top->size++; i > 0 &&
+         top->heap[(i - 1) / 2].frequency > entry.frequency; i = (i - 1) / 2)
+         top->heap[i] = top->heap[(i - 1) / 2];
+      top->heap[i] = entry;
+   } else if (top->k && entry.frequency > top->heap[0].frequency) {
+      top->heap[0] = entry;
+      siftDown(top->heap, top->size, 0);
+   }
+}
+
+static void heapSort(HTEntry *heap, unsigned size) {
+   /* moving the minimum behind the heap until it is gone leaves the array
+    * in descending order */
+   HTEntry min;
+   while (size > 1) {
+      min = heap[0];
+      heap[0] = heap[--size];
+      siftDown(heap, size, 0);
+      heap[size] = min;
+   }
+}
+
+static void topRange(HashTable *ht, unsigned begin, unsigned end,
+   TopHeap *top) {
+   unsigned index = begin, node = 0;
+   HTEntry entry;
+   while (walkNext(ht, &index, &node, end, &entry))
+      heapOffer(top, entry);
+}
+
+static void* topTask(void *arg) {
+   TopTask *task = arg;
+   topRange(task->ht, task->begin, task->end, &(task->top));
+   return NULL;
+}
+
+unsigned htTopK(void *hashTable, unsigned k, HTEntry out[]) {
+   /* out is the heap, nothing else is allocated */
+   HashTable *ht = hashTable;
+   TopHeap top;
+   top.heap = out;
+   top.k = k;
+   top.size = 0;
+   topRange(ht, 0, walkSize(ht), &top);
+   heapSort(out, top.size);
+   return top.size;
+}
+
+unsigned htTopKParallel(void *hashTable, unsigned k, HTEntry out[],
+   unsigned threads) {
+   HashTable *ht = hashTable;
+   unsigned t, i, span = walkSize(ht), chunk, extra;
+   TopTask *tasks;
+   pthread_t *ids;
+   int *started;
+   TopHeap top;
+
+   if (threads > span)
+      threads = span;
+   if (k > htUniqueEntries(ht))
+      k = htUniqueEntries(ht);
+   if (threads <= 1 || k == 0)
+      return htTopK(ht, k, out);
+
+   tasks = malloc(threads * sizeof(TopTask));
+   ids = malloc(threads * sizeof(pthread_t));
+   started = malloc(threads * sizeof(int));
+   CHECK_ALLOC(tasks);
+   CHECK_ALLOC(ids);
+   CHECK_ALLOC(started);
+   chunk = span / threads;
+   extra = span % threads;
+   for (t = 0; t < threads; t++) {
+      tasks[t].ht = ht;
+      tasks[t].begin = t * chunk + (t < extra ? t : extra);
+      tasks[t].end = tasks[t].begin + chunk + (t < extra);
+      tasks[t].top.heap = malloc(k * sizeof(HTEntry));
+      CHECK_ALLOC(tasks[t].top.heap);
+      tasks[t].top.k = k;
+      tasks[t].top.size = 0;
+   }
+
+   /* the calling thread takes the first range, and any range a thread
+    * could not be started for */
+   for (t = 1; t < threads; t++)
+      started[t] = pthread_create(ids + t, NULL, topTask, tasks + t) == 0;
+   topTask(tasks);
+   for (t = 1; t < threads; t++) {
+      if (started[t])
+         pthread_join(ids[t], NULL);
+      else
+         topTask(tasks + t);
+   }
+
+   top.heap = out;
+   top.k = k;
+   top.size = 0;
+   for (t = 0; t < threads; t++) {
+      for (i = 0; i < tasks[t].top.size; i++)
+         heapOffer(&top, tasks[t].top.heap[i]);
+      free(tasks[t].top.heap);
+   }
+   heapSort(out, top.size);
+   free(tasks);
+   free(ids);
+   free(started);
+   return top.size;
+}
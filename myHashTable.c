@@ -4,14 +4,9 @@
 #include "hashTable.h"
 #include "hashmacros.h"
 #include "hashfuncs.h"
-
-#define NUMS_SIZE 5
-
-#define NUM_SIZES 0
-#define CAP  1
-#define TOT_ENTRS 2
-#define UNI_ENTRS 3
-#define CUR_SIZE_INDEX 4
+#include "hashopen.h"
+#include "hashstripe.h"
+#include "hashatomic.h"
 
 void assertSizes(unsigned sizes[], int numSizes)
 {
@@ -22,190 +17,807 @@ void assertSizes(unsigned sizes[], int numSizes)
       assert(sizes[i] < sizes[i + 1]);
 }
 
+HTOptions htDefaultOptions(void)
+{
+   HTOptions opts;
+   opts.engine = HT_CHAINED;
+   opts.rehashStep = 0;
+   opts.tagged = 0;
+   opts.layout = HT_AOS;
+   opts.inlineKeyWidth = 0;
+   opts.keySize = NULL;
+   opts.growth = HT_GROW_LADDER;
+   opts.hash64 = NULL;
+   opts.hashBytes = NULL;
+   opts.equal = NULL;
+   opts.shrinkLoadFactor = 0;
+   opts.stripes = 0;
+   opts.rehashThreads = 0;
+   return opts;
+}
+
+void assertOptions(HTOptions *opts)
+{
+   assert(opts->engine == HT_CHAINED || opts->engine == HT_OPEN ||
+      opts->engine == HT_ATOMIC);
+   assert(opts->engine == HT_CHAINED || opts->rehashStep == 0);
+   assert(opts->engine == HT_OPEN || !opts->tagged);
+   assert(opts->layout == HT_AOS || opts->layout == HT_SOA);
+   assert(opts->engine == HT_OPEN || opts->layout == HT_AOS);
+   assert(opts->engine == HT_OPEN || opts->inlineKeyWidth == 0);
+   assert(opts->inlineKeyWidth <= HT_MAX_INLINE_KEY);
+   assert(opts->inlineKeyWidth == 0 || opts->keySize != NULL);
+   assert(opts->growth == HT_GROW_LADDER || opts->growth == HT_GROW_PRIME ||
+      opts->growth == HT_GROW_POW2);
+   assert(opts->hashBytes == NULL || opts->hash64 == NULL);
+   assert(opts->shrinkLoadFactor >= 0.0 && opts->shrinkLoadFactor < 1.0);
+   assert(opts->stripes == 0 || (opts->engine == HT_CHAINED &&
+      opts->rehashStep == 0 && opts->hashBytes == NULL &&
+      opts->shrinkLoadFactor == 0));
+   assert(opts->rehashThreads <= 1 || (opts->engine == HT_CHAINED &&
+      opts->rehashStep == 0));
+   assert(opts->engine != HT_ATOMIC || (opts->hash64 == NULL &&
+      opts->hashBytes == NULL && opts->shrinkLoadFactor == 0));
+}
+
 void* htCreate(
    HTFunctions *functions,
    unsigned sizes[],
    int numSizes,
    float rehashLoadFactor)
+{
+   return htCreateOpts(functions, sizes, numSizes, rehashLoadFactor, NULL);
+}
+
+void* htCreateOpts(
+   HTFunctions *functions,
+   unsigned sizes[],
+   int numSizes,
+   float rehashLoadFactor,
+   HTOptions *options)
 {
    int i;
    HashTable *ht = malloc(sizeof(HashTable));
 
    assertSizes(sizes, numSizes);
    assert(rehashLoadFactor > 0.0 && rehashLoadFactor <= 1.0);
-   
+   assert(options == NULL || options->shrinkLoadFactor < rehashLoadFactor);
+   CHECK_ALLOC(ht);
+
    ht->sizes = calloc(numSizes, sizeof(unsigned));
    ht->funcs = malloc(sizeof(HTFunctions));
-   ht->hashArr = calloc(sizes[0], sizeof(HashNode*));
+   ht->opts = malloc(sizeof(HTOptions));
    ht->nums = calloc(NUMS_SIZE, sizeof(int));
    ht->rehashFactor = malloc(sizeof(float));
+   ht->match = malloc(sizeof(HashMatch));
+   ht->reduce = malloc(sizeof(HashReducer));
+   ht->oldReduce = malloc(sizeof(HashReducer));
 
-   CHECK_ALLOC(ht);
    CHECK_ALLOC(ht->sizes);
-   CHECK_ALLOC(ht->hashArr);
    CHECK_ALLOC(ht->funcs);
+   CHECK_ALLOC(ht->opts);
    CHECK_ALLOC(ht->nums);
+   CHECK_ALLOC(ht->rehashFactor);
+   CHECK_ALLOC(ht->match);
+   CHECK_ALLOC(ht->reduce);
+   CHECK_ALLOC(ht->oldReduce);
+
+   *(ht->opts) = (options != NULL) ? *options : htDefaultOptions();
+   assertOptions(ht->opts);
+   ht->hashArr = NULL;
+   ht->oldArr = NULL;
+   ht->slots = NULL;
+   ht->arena = NULL;
+   ht->stripes = NULL;
+   ht->atomic = NULL;
+   reducerInit(ht->reduce, sizes[0]);
+   if (ht->opts->engine == HT_OPEN) {
+      ht->slots = slotsCreate(sizes[0], ht->opts);
+   } else if (ht->opts->engine == HT_CHAINED) {
+      ht->hashArr = calloc(sizes[0], sizeof(HashBucket*));
+      CHECK_ALLOC(ht->hashArr);
+   }
+   if (ht->opts->stripes) {
+      /* rehashes run under every lock and may use any one arena */
+      ht->stripes = stripesCreate(ht->opts->stripes, ht->reduce);
+      ht->arena = stripeArena(ht, 0);
+   } else if (ht->opts->engine == HT_CHAINED) {
+      ht->arena = arenaCreate();
+   }
 
    for (i = 0; i < numSizes; i++) {
       ht->sizes[i] = sizes[i];
    }
 
    *(ht->funcs) = *functions;
+   assert(ht->funcs->compare != NULL || ht->opts->equal != NULL);
+   ht->match->compare = ht->funcs->compare;
+   ht->match->equal = ht->opts->equal;
+   assert(ht->opts->inlineKeyWidth == 0 || ht->funcs->destroy == NULL);
    ht->nums[NUM_SIZES] = numSizes;
    ht->nums[CAP] = sizes[0];
    ht->nums[TOT_ENTRS] = 0;
    ht->nums[UNI_ENTRS] = 0;
    ht->nums[CUR_SIZE_INDEX] = 0;
+   ht->nums[OLD_CAP] = 0;
+   ht->nums[MIGRATE_INDEX] = 0;
    *(ht->rehashFactor) = rehashLoadFactor;
+   /* its first limit depends on the ladder */
+   if (ht->opts->engine == HT_ATOMIC)
+      ht->atomic = atomicCreate(ht, sizes[0]);
    return ht;
 }
 
-void htDestroy(void *hashTable)
+void freeArrData(HashTable *ht, HashBucket **hashArr, unsigned cap,
+   int keepData)
 {
-   int h;
-   HashTable *ht = hashTable;
-   /* free data alloc'd by htAdd */
-   for (h = 0; h < htCapacity(ht); h++) {
-      if (ht->hashArr[h] == NULL)
-         continue;
-      freeListData(ht->hashArr[h], ht->funcs->destroy);
+   unsigned h;
+   for (h = 0; h < cap && !keepData; h++) {
+      if (hashArr[h] != NULL)
+         freeListData(hashArr[h], ht->funcs->destroy);
+   }
+   free(hashArr);
+}
+
+void destroyTable(HashTable *ht, int keepData)
+{
+   /* free data alloc'd by htAdd, unless it was handed to another table */
+   if (ht->opts->engine == HT_OPEN) {
+      openDestroy(ht, keepData);
+   } else if (ht->opts->engine == HT_ATOMIC) {
+      atomicDestroy(ht, keepData);
+   } else {
+      freeArrData(ht, ht->hashArr, htCapacity(ht), keepData);
+      if (ht->oldArr != NULL)
+         freeArrData(ht, ht->oldArr, ht->nums[OLD_CAP], keepData);
+      if (ht->stripes != NULL)
+         stripesDestroy(ht->stripes);
+      else
+         arenaDestroy(ht->arena);
    }
-   
+
    /* free data alloc'd by htCreate */
    free(ht->rehashFactor);
+   free(ht->match);
+   free(ht->reduce);
+   free(ht->oldReduce);
    free(ht->sizes);
-   free(ht->hashArr);
    free(ht->funcs);
+   free(ht->opts);
    free(ht->nums);
    free(ht);
 }
 
+void htDestroy(void *hashTable)
+{
+   destroyTable(hashTable, 0);
+}
+
+/* roughly doubling primes for HT_GROW_PRIME */
+static const unsigned growPrimes[] = {
+   53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317,
+   196613, 393241, 786433, 1572869, 3145739, 6291469, 12582917, 25165843,
+   50331653, 100663319, 201326611, 402653189, 805306457, 1610612741
+};
+
+unsigned growthStep(HashTable *ht, unsigned long cap) {
+   /* the capacity after cap past the ladder, 0 when there is none */
+   unsigned long target;
+   unsigned i;
+   if (ht->opts->growth == HT_GROW_PRIME) {
+      for (i = 0; i < sizeof(growPrimes) / sizeof(unsigned); i++) {
+         if (growPrimes[i] >= 2 * cap)
+            return growPrimes[i];
+      }
+   } else if (ht->opts->growth == HT_GROW_POW2) {
+      for (target = 1; target < 2 * cap; target <<= 1)
+         ;
+      if (target <= INT_MAX)
+         return target;
+   }
+   return 0;
+}
+
+unsigned nextCapacity(HashTable *ht) {
+   /* the capacity the next rehash moves to, 0 when there is none */
+   if (ht->nums[CUR_SIZE_INDEX] + 1 != ht->nums[NUM_SIZES])
+      return ht->sizes[ht->nums[CUR_SIZE_INDEX] + 1];
+   return growthStep(ht, htCapacity(ht));
+}
+
 int hashCondition(HashTable *ht) {
    return ((*(ht->rehashFactor) != 1.0 &&
-      ht->nums[CUR_SIZE_INDEX] + 1 != ht->nums[NUM_SIZES] &&
-      ((double)(htUniqueEntries(ht))) / htCapacity(ht) > *(ht->rehashFactor)));
+      ((double)(htUniqueEntries(ht))) / htCapacity(ht) > *(ht->rehashFactor) &&
+      nextCapacity(ht) != 0));
+}
+
+void migrate(HashTable *ht, int numBuckets) {
+   /* moves up to numBuckets old buckets of an incremental rehash */
+   int h;
+   for (h = ht->nums[MIGRATE_INDEX];
+      numBuckets > 0 && h < ht->nums[OLD_CAP]; numBuckets--, h++) {
+      if (ht->oldArr[h] == NULL)
+         continue;
+      moveBucket(ht->arena, ht->oldArr[h], ht->hashArr, ht->reduce,
+         ht->opts->hash64 != NULL);
+      ht->oldArr[h] = NULL;
+   }
+   ht->nums[MIGRATE_INDEX] = h;
+   if (h == ht->nums[OLD_CAP]) {
+      free(ht->oldArr);
+      ht->oldArr = NULL;
+   }
 }
 
-void rehash(HashTable *ht) { 
-   int newCap;
-   HashNode** newHashArr;
+HashNode* findOld(HashTable *ht, void *data, unsigned hash, unsigned high,
+   const HashMatch *match) {
+   /* buckets already migrated are NULL in the old array */
+   HashBucket *bucket;
+   if (ht->oldArr == NULL)
+      return NULL;
+   bucket = ht->oldArr[REDUCE(ht->oldReduce, hash)];
+   if (bucket == NULL)
+      return NULL;
+   return findInBucket(bucket, data, hash, high, ht->opts->hash64 != NULL,
+      match);
+}
+
+void resize(HashTable *ht, int newCap) {
+   HashBucket** newHashArr;
+   if (ht->opts->engine == HT_OPEN) {
+      openRehash(ht, newCap);
+   } else if (ht->opts->rehashStep) {
+      if (ht->oldArr != NULL)
+         migrate(ht, ht->nums[OLD_CAP]);
+      ht->oldArr = ht->hashArr;
+      ht->nums[OLD_CAP] = htCapacity(ht);
+      *(ht->oldReduce) = *(ht->reduce);
+      ht->nums[MIGRATE_INDEX] = 0;
+      ht->hashArr = calloc(newCap, sizeof(HashBucket*));
+      CHECK_ALLOC(ht->hashArr);
+   } else {
+      newHashArr = calloc(newCap, sizeof(HashBucket*));
+      CHECK_ALLOC(newHashArr);
+      /* rehashing down compacts the arena, which rehashValues does */
+      if (ht->opts->rehashThreads > 1 && newCap > (int)htCapacity(ht))
+         rehashParallel(ht, newHashArr, newCap);
+      else
+         rehashValues(ht, newHashArr, newCap);
+      ht->hashArr = newHashArr;
+   }
+   ht->nums[CAP] = newCap;
+   reducerInit(ht->reduce, newCap);
+}
+
+void grow(HashTable *ht, unsigned newCap) {
+   /* past the last size the index stays put */
+   if (ht->nums[CUR_SIZE_INDEX] + 1 != ht->nums[NUM_SIZES])
+      ht->nums[CUR_SIZE_INDEX] = ht->nums[CUR_SIZE_INDEX] + 1;
+   resize(ht, newCap);
+}
+
+void rehash(HashTable *ht) {
    if (!hashCondition(ht))
       return;
-   ht->nums[CUR_SIZE_INDEX] = ht->nums[CUR_SIZE_INDEX] + 1;
-   newCap = ht->sizes[ht->nums[CUR_SIZE_INDEX]];
-   newHashArr = calloc(newCap, sizeof(HashNode*));
-   CHECK_ALLOC(newHashArr);
-   rehashValues(ht, newHashArr, newCap);
-   ht->hashArr = newHashArr;
-   ht->nums[CAP] = newCap;
+   grow(ht, nextCapacity(ht));
+}
+
+int fitsLoad(HashTable *ht, unsigned entries, unsigned long cap) {
+   return entries <= cap && (double)entries / cap <= *(ht->rehashFactor);
+}
+
+void shrink(HashTable *ht, unsigned entries) {
+   /* rehashes to the smallest capacity below the current one that holds
+    * entries, trying the ladder first and then the growth policy */
+   unsigned long cap;
+   int i;
+   for (i = 0; i <= ht->nums[CUR_SIZE_INDEX]; i++) {
+      if (ht->sizes[i] < htCapacity(ht) &&
+         fitsLoad(ht, entries, ht->sizes[i])) {
+         ht->nums[CUR_SIZE_INDEX] = i;
+         resize(ht, ht->sizes[i]);
+         return;
+      }
+   }
+   for (cap = ht->sizes[ht->nums[NUM_SIZES] - 1];
+      (cap = growthStep(ht, cap)) != 0 && cap < htCapacity(ht);) {
+      if (fitsLoad(ht, entries, cap)) {
+         resize(ht, cap);
+         return;
+      }
+   }
+}
+
+void growFull(HashTable *ht) {
+   /* open addressing needs a free slot even when rehashing is disabled */
+   unsigned newCap;
+   if (htUniqueEntries(ht) < htCapacity(ht))
+      return;
+   if ((newCap = nextCapacity(ht)) == 0)
+      newCap = 2 * htCapacity(ht) + 1;
+   grow(ht, newCap);
+}
+
+void countEntries(HashTable *ht, unsigned s, int unique, int total)
+{
+   /* s is the locked stripe of a thread safe table */
+   if (ht->stripes != NULL) {
+      stripeCount(ht, s, unique, total);
+   } else {
+      ht->nums[UNI_ENTRS] += unique;
+      ht->nums[TOT_ENTRS] += total;
+   }
+}
+
+void stripedRehash(HashTable *ht)
+{
+   /* a crowded stripe may just be unlucky, the real load decides */
+   stripesLockAll(ht);
+   rehash(ht);
+   stripesUnlockAll(ht);
+}
+
+unsigned addHashed(HashTable *ht, void *data, unsigned hash, unsigned high,
+   unsigned count)
+{
+   /* htAdd once data is hashed, adding count to its frequency */
+   int ret, crowded;
+   unsigned h, s = 0;
+   HashNode newNode, *found;
+
+   if (ht->opts->engine == HT_ATOMIC)
+      return atomicAdd(ht, data, hash, count);
+   if (ht->stripes != NULL)
+      s = stripeLock(ht, hash);
+   else
+      rehash(ht);
+
+   if (ht->opts->engine == HT_OPEN) {
+      growFull(ht);
+      ret = openAdd(ht, data, hash, high, count);
+      countEntries(ht, s, ret == count, count);
+      return ret;
+   }
+
+   if (ht->oldArr != NULL)
+      migrate(ht, ht->opts->rehashStep);
+   newNode.data = data;
+   newNode.frequency = count;
+   newNode.hash = hash;
+   h = REDUCE(ht->reduce, hash);
+   if ((found = findOld(ht, data, hash, high, ht->match)) != NULL)
+      ret = found->frequency += count;
+   else
+      ret = addToHashArr(stripeArena(ht, h), ht->hashArr, h, &newNode, high,
+         ht->opts->hash64 != NULL, ht->match);
+   countEntries(ht, s, ret == count, count);
+
+   if (ht->stripes != NULL) {
+      crowded = ret == count && stripeCrowded(ht, s);
+      stripeUnlock(ht, s);
+      if (crowded)
+         stripedRehash(ht);
+   }
+   return ret;
 }
 
 unsigned htAdd(void *hashTable, void *data)
 {
-   int h, ret;
-   HTEntry newEntry;
-   HashNode newNode; 
+   unsigned hash, high;
    HashTable *ht = (HashTable*)(hashTable);
-   unsigned (*hash)(const void *data) = ht->funcs->hash;
    assert(data != NULL);
+   hash = hashData(ht, data, &high);
+   return addHashed(ht, data, hash, high, 1);
+}
+
+HTEntry lookUpHashed(HashTable *ht, void *data, unsigned hash, unsigned high)
+{
+   /* htLookUp once data is hashed */
+   HashNode *found;
+   HTEntry entry = invalidEntry();
+   unsigned h, s = 0;
+   if (ht->opts->engine == HT_OPEN)
+      return openLookUp(ht, data, hash, high);
+   if (ht->opts->engine == HT_ATOMIC)
+      return atomicLookUp(ht, data, hash);
+   if (ht->stripes != NULL)
+      s = stripeLock(ht, hash);
+   if (ht->oldArr != NULL)
+      migrate(ht, ht->opts->rehashStep);
+   h = REDUCE(ht->reduce, hash);
+   if ((ht->hashArr[h] != NULL && (found = findInBucket(ht->hashArr[h], data,
+      hash, high, ht->opts->hash64 != NULL, ht->match)) != NULL)
+      || (found = findOld(ht, data, hash, high, ht->match)) != NULL)
+      entry = nodeEntry(found);
+   if (ht->stripes != NULL)
+      stripeUnlock(ht, s);
+   return entry;
+}
+
+HTEntry htLookUp(void *hashTable, void *data)
+{
+   unsigned hash, high;
+   HashTable *ht = hashTable;
+   assert(data != NULL);
+   hash = hashData(ht, data, &high);
+   return lookUpHashed(ht, data, hash, high);
+}
+
+unsigned removeHashed(HashTable *ht, void *data, unsigned hash,
+   unsigned high, unsigned count)
+{
+   /* takes up to count off the data's frequency and removes the entry when
+    * nothing is left; returns the frequency it had, 0 when absent */
+   HashBucket **slot;
+   HashArena *arena;
+   HashNode *found = NULL;
+   void *stored = NULL;
+   unsigned h, s = 0, old = 0;
+   int wide = ht->opts->hash64 != NULL;
+
+   assert(ht->opts->engine != HT_ATOMIC);
+   if (ht->opts->engine == HT_OPEN) {
+      old = openRemove(ht, data, hash, high, count);
+   } else {
+      if (ht->stripes != NULL)
+         s = stripeLock(ht, hash);
+      if (ht->oldArr != NULL)
+         migrate(ht, ht->opts->rehashStep);
+      h = REDUCE(ht->reduce, hash);
+      slot = ht->hashArr + h;
+      arena = stripeArena(ht, h);
+      if (*slot != NULL)
+         found = findInBucket(*slot, data, hash, high, wide, ht->match);
+      if (found == NULL && ht->oldArr != NULL) {
+         slot = ht->oldArr + REDUCE(ht->oldReduce, hash);
+         arena = ht->arena;
+         if (*slot != NULL)
+            found = findInBucket(*slot, data, hash, high, wide, ht->match);
+      }
+      if (found != NULL && (old = found->frequency) > count) {
+         found->frequency -= count;
+      } else if (found != NULL) {
+         /* data may be the stored pointer itself, it is not used again */
+         stored = found->data;
+         removeNode(arena, slot, found, wide);
+      }
+   }
+
+   if (old > count) {
+      countEntries(ht, s, 0, -(int)count);
+   } else if (old != 0) {
+      countEntries(ht, s, -1, -(int)old);
+      /* room to grow back before the next rehash up */
+      if ((double)htUniqueEntries(ht) / htCapacity(ht) <
+         ht->opts->shrinkLoadFactor)
+         shrink(ht, 2 * htUniqueEntries(ht));
+   }
+   if (ht->stripes != NULL)
+      stripeUnlock(ht, s);
+   if (stored != NULL)
+      freeData(stored, ht->funcs->destroy);
+   return old;
+}
+
+void htShrinkToFit(void *hashTable)
+{
+   HashTable *ht = hashTable;
+   assert(ht->opts->engine != HT_ATOMIC);
+   /* threads picking stripes later must see the new capacity */
+   if (ht->stripes != NULL)
+      stripesLockAll(ht);
+   shrink(ht, htUniqueEntries(ht));
+   if (ht->oldArr != NULL)
+      migrate(ht, ht->nums[OLD_CAP]);
+   if (ht->stripes != NULL)
+      stripesUnlockAll(ht);
+}
+
+void htReserve(void *hashTable, unsigned expected)
+{
+   HashTable *ht = hashTable;
+   unsigned long cap = htCapacity(ht), next;
+   int index = ht->nums[CUR_SIZE_INDEX];
+   assert(ht->opts->engine != HT_ATOMIC);
+   /* walks up the ladder and then the growth policy like repeated
+    * rehashes would, without moving any entry */
+   while (!fitsLoad(ht, expected, cap)) {
+      if (index + 1 != ht->nums[NUM_SIZES])
+         next = ht->sizes[++index];
+      else if ((next = growthStep(ht, cap)) == 0)
+         break;
+      cap = next;
+   }
+   if (cap == htCapacity(ht))
+      return;
+   if (ht->stripes != NULL)
+      stripesLockAll(ht);
+   ht->nums[CUR_SIZE_INDEX] = index;
+   resize(ht, cap);
+   if (ht->oldArr != NULL)
+      migrate(ht, ht->nums[OLD_CAP]);
+   if (ht->stripes != NULL)
+      stripesUnlockAll(ht);
+}
+
+size_t htArenaBytes(void *hashTable)
+{
+   HashTable *ht = hashTable;
+   size_t bytes = 0;
+   unsigned s;
+   if (ht->stripes != NULL) {
+      for (s = 0; s < ht->stripes->count; s++)
+         bytes += stripeArena(ht, s)->bytes;
+      return bytes;
+   }
+   return (ht->arena != NULL) ? ht->arena->bytes : 0;
+}
+
+unsigned htRemove(void *hashTable, void *data)
+{
+   unsigned hash, high;
+   HashTable *ht = hashTable;
+   assert(data != NULL);
+   hash = hashData(ht, data, &high);
+   return removeHashed(ht, data, hash, high, UINT_MAX);
+}
+
+unsigned htDecrement(void *hashTable, void *data)
+{
+   unsigned hash, high, old;
+   HashTable *ht = hashTable;
+   assert(data != NULL);
+   hash = hashData(ht, data, &high);
+   old = removeHashed(ht, data, hash, high, 1);
+   return old ? old - 1 : 0;
+}
+
+/* keys hashed and prefetched ahead of being resolved */
+#define BATCH_CHUNK 16
+
+static void prefetchChunk(HashTable *ht, unsigned hashes[], unsigned count)
+{
+   /* chained tables need two rounds: the bucket pointer, then the bucket */
+   unsigned i;
+   /* the arrays of a thread safe table may be replaced meanwhile */
+   if (ht->stripes != NULL || ht->atomic != NULL)
+      return;
+   if (ht->opts->engine == HT_OPEN) {
+      for (i = 0; i < count; i++)
+         openPrefetch(ht, hashes[i]);
+      return;
+   }
+   for (i = 0; i < count; i++)
+      PREFETCH(ht->hashArr + REDUCE(ht->reduce, hashes[i]));
+   for (i = 0; i < count; i++)
+      PREFETCH(ht->hashArr[REDUCE(ht->reduce, hashes[i])]);
+}
+
+void htAddBatch(void *hashTable, void *data[], unsigned count,
+   unsigned freqs[])
+{
+   unsigned i, j, n, ret, hashes[BATCH_CHUNK], highs[BATCH_CHUNK];
+   HashTable *ht = hashTable;
+   for (i = 0; i < count; i += n) {
+      n = (count - i < BATCH_CHUNK) ? count - i : BATCH_CHUNK;
+      for (j = 0; j < n; j++) {
+         assert(data[i + j] != NULL);
+         hashes[j] = hashData(ht, data[i + j], highs + j);
+      }
+      /* an add may grow the table, the prefetches are only hints */
+      prefetchChunk(ht, hashes, n);
+      for (j = 0; j < n; j++) {
+         ret = addHashed(ht, data[i + j], hashes[j], highs[j], 1);
+         if (freqs != NULL)
+            freqs[i + j] = ret;
+      }
+   }
+}
+
+void htLookUpBatch(void *hashTable, void *data[], unsigned count,
+   HTEntry entries[])
+{
+   unsigned i, j, n, hashes[BATCH_CHUNK], highs[BATCH_CHUNK];
+   HashTable *ht = hashTable;
+   for (i = 0; i < count; i += n) {
+      n = (count - i < BATCH_CHUNK) ? count - i : BATCH_CHUNK;
+      for (j = 0; j < n; j++) {
+         assert(data[i + j] != NULL);
+         hashes[j] = hashData(ht, data[i + j], highs + j);
+      }
+      prefetchChunk(ht, hashes, n);
+      for (j = 0; j < n; j++)
+         entries[i + j] = lookUpHashed(ht, data[i + j], hashes[j], highs[j]);
+   }
+}
+
+unsigned htAddSlice(void *hashTable, const char *key, size_t len)
+{
+   int h, ret = 1;
+   HashNode newNode, *found;
+   HashSlice slice;
+   HashTable *ht = hashTable;
+   assert(key != NULL && ht->opts->hashBytes != NULL);
+   slice.key = key;
+   slice.len = len;
 
    rehash(ht);
 
-   newEntry.frequency = 1;
-   newEntry.data = data;
-   h = initNode(newEntry, &newNode, htCapacity(ht), (*hash));
-   if ((ret=addToHashArr(ht->hashArr, h, &newNode, ht->funcs->compare)) == 1)
+   if (ht->opts->engine == HT_OPEN) {
+      growFull(ht);
+      if ((ret = openAddSlice(ht, &slice)) == 1)
+         ht->nums[UNI_ENTRS] += 1;
+      ht->nums[TOT_ENTRS] += 1;
+      return ret;
+   }
+
+   if (ht->oldArr != NULL)
+      migrate(ht, ht->opts->rehashStep);
+   newNode.hash = (*(ht->opts->hashBytes))(key, len);
+   h = REDUCE(ht->reduce, newNode.hash);
+   if ((ht->hashArr[h] != NULL && (found = findInBucket(ht->hashArr[h],
+      &slice, newNode.hash, 0, 0, &sliceMatch)) != NULL) ||
+      (found = findOld(ht, &slice, newNode.hash, 0, &sliceMatch)) != NULL) {
+      ret = ++(found->frequency);
+   } else {
+      /* only new strings are copied */
+      newNode.data = sliceCopy(&slice);
+      newNode.frequency = 1;
+      appendToHashArr(ht->arena, ht->hashArr, h, &newNode, 0, 0);
       ht->nums[UNI_ENTRS] += 1;
+   }
    ht->nums[TOT_ENTRS] += 1;
    return ret;
 }
 
-HTEntry htLookUp(void *hashTable, void *data)
+HTEntry htLookUpSlice(void *hashTable, const char *key, size_t len)
 {
    HashTable *ht = hashTable;
-   unsigned h, i, (*hash)(const void *data) = ht->funcs->hash;
-   int (*compare)(const void *data1, const void *data2) = ht->funcs->compare;
-   assert(data != NULL);
-   h = hashData(data, htCapacity(ht), *hash);
-   if (ht->hashArr[h] == NULL)
+   HashNode *found;
+   HashSlice slice;
+   unsigned h, fullHash;
+   assert(key != NULL && ht->opts->hashBytes != NULL);
+   slice.key = key;
+   slice.len = len;
+   if (ht->opts->engine == HT_OPEN)
+      return openLookUpSlice(ht, &slice);
+   if (ht->oldArr != NULL)
+      migrate(ht, ht->opts->rehashStep);
+   fullHash = (*(ht->opts->hashBytes))(key, len);
+   h = REDUCE(ht->reduce, fullHash);
+   if ((ht->hashArr[h] == NULL || (found = findInBucket(ht->hashArr[h],
+      &slice, fullHash, 0, 0, &sliceMatch)) == NULL) &&
+      (found = findOld(ht, &slice, fullHash, 0, &sliceMatch)) == NULL)
       return invalidEntry();
-   for (i = 0; i < ht->hashArr[h][0].listSize; i++) {
-      if ((*compare)(ht->hashArr[h][i].entry.data, data) == 0) {
-         HTEntry *entry = &(ht->hashArr[h][i].entry);
-         return *entry;
-      }
+   return nodeEntry(found);
+}
+
+void htIterInit(void *hashTable, HTIterator *it)
+{
+   it->table = hashTable;
+   it->index = 0;
+   it->node = 0;
+}
+
+int htIterNext(HTIterator *it, HTEntry *entry)
+{
+   HashTable *ht = it->table;
+   return walkNext(ht, &(it->index), &(it->node), walkSize(ht), entry);
+}
+
+unsigned htForEach(void *hashTable, FNVisit visit, void *context)
+{
+   HTIterator it;
+   HTEntry entry;
+   unsigned visited = 0;
+   htIterInit(hashTable, &it);
+   while (htIterNext(&it, &entry)) {
+      visited++;
+      if ((*visit)(entry, context))
+         break;
    }
-   return invalidEntry();
+   return visited;
 }
 
-void convertToArr(HashTable *ht, HTEntry **entries, unsigned *allocSize,
-   unsigned *size, unsigned h) {
-   int i;
-   for (i = 0; i < ht->hashArr[h][0].listSize; i++) {
-      (*entries)[*size] = ht->hashArr[h][i].entry;
-      *size += 1;
-      if (*size >= *allocSize) {
-         *allocSize *= 2;
-         *entries = realloc(*entries, (*allocSize) * sizeof(HTEntry));
-         CHECK_ALLOC(*entries);
-      }
+unsigned chainToArray(HashBucket **hashArr, unsigned cap, HTEntry *entries)
+{
+   unsigned h, i, n = 0;
+   for (h = 0; h < cap; h++) {
+      if (hashArr[h] == NULL)
+         continue;
+      for (i = 0; i < hashArr[h]->size; i++)
+         entries[n++] = nodeEntry(BUCKET_NODES(hashArr[h]) + i);
    }
+   return n;
 }
 
 HTEntry* htToArray(void *hashTable, unsigned *size)
 {
-   unsigned h, allocSize = 4;
    HashTable *ht = hashTable;
+   HTIterator it;
    HTEntry *entries;
    *size = 0;
-   if (!htTotalEntries(ht)) {
+   if (!htUniqueEntries(ht)) {
       return NULL;
    }
-   entries = malloc(sizeof(HTEntry) * allocSize);
+   /* the entry count is known, so one exact allocation; whole arrays are
+    * copied by a loop of their own rather than an iterator step each */
+   entries = malloc(sizeof(HTEntry) * htUniqueEntries(ht));
    CHECK_ALLOC(entries);
-   for (h = 0; h < htCapacity(ht); h++) {
-      if (ht->hashArr[h] == NULL)
-         continue;
-      convertToArr(ht, &entries, &allocSize, size, h);
+   if (ht->opts->engine == HT_OPEN) {
+      *size = openToArray(ht, entries);
+   } else if (ht->opts->engine == HT_CHAINED) {
+      *size = chainToArray(ht->hashArr, htCapacity(ht), entries);
+      if (ht->oldArr != NULL)
+         *size += chainToArray(ht->oldArr, ht->nums[OLD_CAP],
+            entries + *size);
+   } else {
+      htIterInit(ht, &it);
+      while (htIterNext(&it, entries + *size))
+         *size += 1;
    }
-   entries = realloc(entries, *size);
-   CHECK_ALLOC(entries);
    return entries;
 }
 
 unsigned htCapacity(void *hashTable)
 {
-   return ((HashTable*)(hashTable))->nums[CAP];
+   HashTable *ht = hashTable;
+   if (ht->atomic != NULL)
+      return atomicCapacity(ht);
+   return ht->nums[CAP];
 }
 
 unsigned htUniqueEntries(void *hashTable)
 {
-   return ((HashTable*)(hashTable))->nums[UNI_ENTRS];
+   HashTable *ht = hashTable;
+   if (ht->stripes != NULL)
+      return stripeSum(ht, 1);
+   if (ht->atomic != NULL)
+      return atomicSum(ht, 1);
+   return ht->nums[UNI_ENTRS];
 }
 
 unsigned htTotalEntries(void *hashTable)
 {
-   return ((HashTable*)(hashTable))->nums[TOT_ENTRS];
+   HashTable *ht = hashTable;
+   if (ht->stripes != NULL)
+      return stripeSum(ht, 0);
+   if (ht->atomic != NULL)
+      return atomicSum(ht, 0);
+   return ht->nums[TOT_ENTRS];
 }
 
-HTMetrics htMetrics(void *hashTable)
+void chainMetrics(HTMetrics *met, double *totalLength, HashBucket **hashArr,
+   unsigned cap)
 {
    unsigned h;
-   double totalLength;
+   for (h = 0; h < cap; h++) {
+      if (hashArr[h] == NULL)
+         continue;
+      met->numberOfChains++;
+      met->maxChainLength = (met->maxChainLength > hashArr[h]->size) ?
+         met->maxChainLength : hashArr[h]->size;
+      *totalLength += hashArr[h]->size;
+   }
+}
+
+HTMetrics htMetrics(void *hashTable)
+{
+   double totalLength = 0;
    HashTable *ht = hashTable;
    HTMetrics met;
+   if (ht->opts->engine == HT_OPEN)
+      return openMetrics(ht);
+   if (ht->opts->engine == HT_ATOMIC)
+      return atomicMetrics(ht);
    met.numberOfChains = 0;
    met.maxChainLength = 0;
    met.avgChainLength = 0;
-   
-   for (h = 0; h < htCapacity(ht); h++) {
-      if (ht->hashArr[h] == NULL)
-         continue;
-      met.numberOfChains++;
-      met.maxChainLength = (met.maxChainLength > ht->hashArr[h][0].listSize) ?
-         met.maxChainLength : ht->hashArr[h][0].listSize;
-      totalLength += ht->hashArr[h][0].listSize;
-   }
-   met.avgChainLength = totalLength / met.numberOfChains;
+
+   chainMetrics(&met, &totalLength, ht->hashArr, htCapacity(ht));
+   if (ht->oldArr != NULL)
+      chainMetrics(&met, &totalLength, ht->oldArr, ht->nums[OLD_CAP]);
+   if (met.numberOfChains)
+      met.avgChainLength = totalLength / met.numberOfChains;
    return met;
 }
@@ -8,14 +8,21 @@
  *
  * Author: Kurt Mammen
  */
+/* clock_gettime for the wall clock of threaded benchmarks */
+#define _POSIX_C_SOURCE 199309L
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <limits.h>
 #include <float.h>
+#include <time.h>
+#include <pthread.h>
 #include "unitTest.h"
 #include "hashTable.h"
+#include "hashTableExt.h"
+#include "hashlib.h"
+#include "hashgen.h"
 
 #define TEST_ALL -1
 #define REGULAR -2 
@@ -316,6 +323,18 @@ static char* nonRandomString()
    return string;
 }
 
+static char* copyString(const char *str)
+{
+   char *copy = malloc(strlen(str) + 1);
+
+   if (copy == NULL)
+   {
+      perror("copyString()");
+      exit(EXIT_FAILURE);
+   }
+   return strcpy(copy, str);
+}
+
 static void core14()
 {
    int freq = 0;
@@ -789,6 +808,9 @@ static void feat09() {
    HTFunctions funcs = {hashString, compareString, NULL};
    void *ht = htCreate(&funcs, sizes, 1, 1);
 
+   /* expected chain lengths depend on the random strings drawn */
+   srand(182955);
+
    htAdd(ht, string1);
    for (i = 0; i < 5; i++) {
       htAdd(ht, randomString());
@@ -807,6 +829,1551 @@ static void feat09() {
    
 }
 
+static void* createOpen(HTFunctions *funcs, unsigned sizes[], int numSizes,
+   float rehashLoadFactor)
+{
+   HTOptions opts = htDefaultOptions();
+   opts.engine = HT_OPEN;
+   return htCreateOpts(funcs, sizes, numSizes, rehashLoadFactor, &opts);
+}
+
+static void feat10() {
+   int i;
+   unsigned size;
+   HTEntry entry;
+   HTEntry *entries;
+   char *strings[20];
+   char *string1 = nonRandomString();
+   char *string2 = nonRandomString();
+   unsigned sizes[] = {31};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   void *ht = createOpen(&funcs, sizes, 1, 0.73);
+
+   for (i = 0; i < 20; i++) {
+      strings[i] = randomString();
+      TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+   }
+   TEST_UNSIGNED(htAdd(ht, string1), 1);
+   TEST_UNSIGNED(htAdd(ht, string2), 2);
+
+   TEST_UNSIGNED(htCapacity(ht), 31);
+   TEST_UNSIGNED(htUniqueEntries(ht), 21);
+   TEST_UNSIGNED(htTotalEntries(ht), 22);
+
+   for (i = 0; i < 20; i++) {
+      entry = htLookUp(ht, strings[i]);
+      TEST_BOOLEAN((entry.data == strings[i]), 1);
+      TEST_UNSIGNED(entry.frequency, 1);
+   }
+   entry = htLookUp(ht, string2);
+   TEST_BOOLEAN((entry.data == string1), 1);
+   TEST_UNSIGNED(entry.frequency, 2);
+
+   entries = htToArray(ht, &size);
+   TEST_UNSIGNED(size, 21);
+   for (i = 0; i < size; i++)
+      TEST_UNSIGNED(htLookUp(ht, entries[i].data).frequency,
+         entries[i].frequency);
+
+   free(entries);
+   free(string2);
+   htDestroy(ht);
+}
+
+static void feat11() {
+   HTEntry entry;
+   unsigned sizes[] = {7, 11};
+   char* string1 = randomString();
+   char* string2 = nonRandomString();
+   char* string3 = nonRandomString();
+   char* string4 = randomString();
+   char* string5 = randomString();
+   HTFunctions funcs = {hashString, compareString, NULL};
+   void *ht = createOpen(&funcs, sizes, 2, 0.40);
+
+   /* same rehash points as feat02 */
+   htAdd(ht, string1);
+   htAdd(ht, string2);
+   htAdd(ht, string3);
+   htAdd(ht, string4);
+   TEST_UNSIGNED(htCapacity(ht), 7);
+
+   htAdd(ht, string5);
+   TEST_UNSIGNED(htCapacity(ht), 11);
+   TEST_UNSIGNED(htUniqueEntries(ht), 4);
+   TEST_UNSIGNED(htTotalEntries(ht), 5);
+
+   entry = htLookUp(ht, string1);
+   TEST_BOOLEAN((entry.data == string1), 1);
+   entry = htLookUp(ht, string3);
+   TEST_BOOLEAN((entry.data == string2), 1);
+   TEST_UNSIGNED(entry.frequency, 2);
+
+   htDestroy(ht);
+   free(string3);
+}
+
+static void feat12() {
+   int i;
+   char *strings[8];
+   unsigned sizes[] = {3};
+   HTFunctions funcs = {badHash, compareString, NULL};
+   void *ht = createOpen(&funcs, sizes, 1, 1.0);
+
+   /* a full open table grows past the last size instead of failing */
+   for (i = 0; i < 8; i++) {
+      strings[i] = randomString();
+      TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+   }
+   TEST_UNSIGNED(htCapacity(ht), 15);
+   TEST_UNSIGNED(htUniqueEntries(ht), 8);
+   for (i = 0; i < 8; i++)
+      TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+
+   htDestroy(ht);
+}
+
+static void feat13() {
+   HTMetrics metrics;
+   unsigned sizes[] = {11};
+   HTFunctions funcs = {badHash, compareString, NULL};
+   void *ht = createOpen(&funcs, sizes, 1, 1.0);
+
+   metrics = htMetrics(ht);
+   TEST_UNSIGNED(metrics.numberOfChains, 0);
+   TEST_UNSIGNED(metrics.maxChainLength, 0);
+
+   htAdd(ht, randomString());
+   htAdd(ht, randomString());
+   htAdd(ht, randomString());
+
+   metrics = htMetrics(ht);
+   TEST_UNSIGNED(metrics.numberOfChains, 1);
+   TEST_UNSIGNED(metrics.maxChainLength, 3);
+   TEST_REAL((double)(metrics.avgChainLength), 3, FLT_EPSILON);
+
+   htDestroy(ht);
+}
+
+static unsigned hashCalls = 0;
+static unsigned compareCalls = 0;
+
+static unsigned countingHash(const void *data)
+{
+   hashCalls++;
+   return hashString(data);
+}
+
+static int countingCompare(const void *a, const void *b)
+{
+   compareCalls++;
+   return strcmp(a, b);
+}
+
+static void feat14() {
+   int i, engine;
+   char *strings[10];
+   char *string1 = nonRandomString();
+   unsigned sizes[] = {7, 11, 13, 17, 29};
+   HTFunctions funcs = {countingHash, countingCompare, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* rehashing reuses the stored hashes and lookups of absent data only
+    * compare against entries with the same full hash */
+   for (engine = HT_CHAINED; engine <= HT_OPEN; engine++) {
+      opts.engine = engine;
+      ht = htCreateOpts(&funcs, sizes, 5, 0.5, &opts);
+      hashCalls = 0;
+      for (i = 0; i < 10; i++) {
+         strings[i] = randomString();
+         htAdd(ht, strings[i]);
+      }
+      TEST_UNSIGNED(htCapacity(ht), 29);
+      TEST_UNSIGNED(hashCalls, 10);
+
+      compareCalls = 0;
+      TEST_BOOLEAN((htLookUp(ht, string1).data == NULL), 1);
+      TEST_UNSIGNED(compareCalls, 0);
+      for (i = 0; i < 10; i++)
+         TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+      TEST_UNSIGNED(compareCalls, 10);
+      htDestroy(ht);
+   }
+   free(string1);
+}
+
+static void feat15() {
+   int i;
+   char *strings[100];
+   HTMetrics metrics;
+   unsigned sizes[] = {11};
+   HTFunctions funcs = {badHash, compareString, NULL};
+   void *ht = htCreate(&funcs, sizes, 1, 1.0);
+
+   /* one chain growing through several bucket capacities */
+   for (i = 0; i < 100; i++) {
+      strings[i] = randomString();
+      TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+   }
+   for (i = 0; i < 100; i++) {
+      TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+      TEST_UNSIGNED(htLookUp(ht, strings[i]).frequency, 1);
+   }
+
+   metrics = htMetrics(ht);
+   TEST_UNSIGNED(metrics.numberOfChains, 1);
+   TEST_UNSIGNED(metrics.maxChainLength, 100);
+
+   htDestroy(ht);
+}
+
+static unsigned fewBucketsHash(const void *data)
+{
+   return hashString(data) % 5;
+}
+
+static void feat16() {
+   int i;
+   char *strings[300];
+   HTEntry entry;
+   unsigned sizes[] = {3, 7, 11, 29, 53};
+   HTFunctions funcs = {fewBucketsHash, compareString, NULL};
+   void *ht = htCreate(&funcs, sizes, 5, 0.5);
+
+   /* chains of many different capacities recycled through every rehash */
+   for (i = 0; i < 300; i++) {
+      strings[i] = randomString();
+      if (htAdd(ht, strings[i]) != 1) {
+         free(strings[i]);
+         strings[i] = NULL;
+      }
+   }
+   TEST_UNSIGNED(htCapacity(ht), 53);
+   for (i = 0; i < 300; i++) {
+      if (strings[i] == NULL)
+         continue;
+      entry = htLookUp(ht, strings[i]);
+      TEST_BOOLEAN((entry.data == strings[i]), 1);
+      TEST_UNSIGNED(entry.frequency, 1);
+   }
+
+   htDestroy(ht);
+}
+
+static void feat17() {
+   int i, j;
+   unsigned size;
+   char *strings[60];
+   char *copy;
+   HTEntry *entries;
+   HTMetrics metrics;
+   unsigned sizes[] = {7, 17, 37, 79, 163};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht, *reference;
+
+   /* lookups, duplicates and capacities while old buckets trickle over */
+   opts.rehashStep = 1;
+   ht = htCreateOpts(&funcs, sizes, 5, 0.5, &opts);
+   reference = htCreate(&funcs, sizes, 5, 0.5);
+   for (i = 0; i < 60; i++) {
+      strings[i] = randomString();
+      htAdd(reference, copyString(strings[i]));
+      TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+      TEST_UNSIGNED(htCapacity(ht), htCapacity(reference));
+      for (j = 0; j <= i; j++)
+         TEST_BOOLEAN((htLookUp(ht, strings[j]).data == strings[j]), 1);
+      if (i % 10 == 0) {
+         copy = copyString(strings[i / 2]);
+         TEST_UNSIGNED(htAdd(ht, copy), 2);
+         free(copy);
+      }
+   }
+   TEST_UNSIGNED(htUniqueEntries(ht), 60);
+   TEST_UNSIGNED(htTotalEntries(ht), 66);
+
+   entries = htToArray(ht, &size);
+   TEST_UNSIGNED(size, 60);
+   metrics = htMetrics(ht);
+   TEST_REAL(metrics.avgChainLength * metrics.numberOfChains, 60, 0.001);
+
+   free(entries);
+   htDestroy(reference);
+   htDestroy(ht);
+}
+
+static void* createTagged(HTFunctions *funcs, unsigned sizes[], int numSizes,
+   float rehashLoadFactor)
+{
+   HTOptions opts = htDefaultOptions();
+   opts.engine = HT_OPEN;
+   opts.tagged = 1;
+   return htCreateOpts(funcs, sizes, numSizes, rehashLoadFactor, &opts);
+}
+
+static void feat18() {
+   int i;
+   char *strings[200];
+   char *string1 = nonRandomString();
+   unsigned sizes[] = {3, 7, 53, 101, 409};
+   HTFunctions funcs = {countingHash, countingCompare, NULL};
+   void *ht = createTagged(&funcs, sizes, 5, 0.8);
+
+   /* grows from tables smaller than one control group */
+   for (i = 0; i < 200; i++) {
+      strings[i] = randomString();
+      TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+   }
+   TEST_UNSIGNED(htCapacity(ht), 409);
+   for (i = 0; i < 200; i++) {
+      TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+      TEST_UNSIGNED(htLookUp(ht, strings[i]).frequency, 1);
+   }
+
+   compareCalls = 0;
+   TEST_BOOLEAN((htLookUp(ht, string1).data == NULL), 1);
+   TEST_UNSIGNED(compareCalls, 0);
+   TEST_UNSIGNED(htAdd(ht, string1), 1);
+   TEST_UNSIGNED(htLookUp(ht, string1).frequency, 1);
+
+   htDestroy(ht);
+}
+
+static void feat19() {
+   int i;
+   char *strings[4];
+   char *string1 = nonRandomString();
+   unsigned sizes[] = {4};
+   HTFunctions funcs = {badHash, compareString, NULL};
+   void *ht = createTagged(&funcs, sizes, 1, 1.0);
+
+   /* a completely full table still ends a lookup of absent data */
+   for (i = 0; i < 4; i++) {
+      strings[i] = randomString();
+      htAdd(ht, strings[i]);
+   }
+   TEST_UNSIGNED(htCapacity(ht), 4);
+   TEST_BOOLEAN((htLookUp(ht, string1).data == NULL), 1);
+   for (i = 0; i < 4; i++)
+      TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+
+   free(string1);
+   htDestroy(ht);
+}
+
+static void feat20() {
+   int i, tagged;
+   unsigned size;
+   char *strings[100];
+   char *string1, *string2;
+   HTEntry *entries;
+   HTMetrics metrics;
+   unsigned sizes[] = {7, 31, 101, 211};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* split slot arrays behave exactly like whole slots */
+   opts.engine = HT_OPEN;
+   opts.layout = HT_SOA;
+   for (tagged = 0; tagged <= 1; tagged++) {
+      opts.tagged = tagged;
+      ht = htCreateOpts(&funcs, sizes, 4, 0.6, &opts);
+      string1 = nonRandomString();
+      string2 = nonRandomString();
+      for (i = 0; i < 100; i++) {
+         strings[i] = randomString();
+         TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+      }
+      TEST_UNSIGNED(htAdd(ht, string1), 1);
+      TEST_UNSIGNED(htAdd(ht, string2), 2);
+      TEST_UNSIGNED(htCapacity(ht), 211);
+      TEST_UNSIGNED(htUniqueEntries(ht), 101);
+      TEST_UNSIGNED(htTotalEntries(ht), 102);
+
+      for (i = 0; i < 100; i++)
+         TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+      TEST_BOOLEAN((htLookUp(ht, string2).data == string1), 1);
+      TEST_UNSIGNED(htLookUp(ht, string2).frequency, 2);
+
+      entries = htToArray(ht, &size);
+      TEST_UNSIGNED(size, 101);
+      for (i = 0; i < size; i++)
+         TEST_UNSIGNED(htLookUp(ht, entries[i].data).frequency,
+            entries[i].frequency);
+      metrics = htMetrics(ht);
+      TEST_REAL(metrics.avgChainLength * metrics.numberOfChains, 101, 0.001);
+
+      free(entries);
+      free(string2);
+      htDestroy(ht);
+   }
+}
+
+static size_t stringSize(const void *data)
+{
+   return strlen(data) + 1;
+}
+
+static void feat21() {
+   int i, layout;
+   unsigned size;
+   char *strings[200], *copies[200];
+   HTEntry *entries;
+   unsigned sizes[] = {7, 31, 101, 409};
+   HTFunctions funcs = {countingHash, countingCompare, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* short strings are copied into the slots, long ones keep their pointer */
+   opts.engine = HT_OPEN;
+   opts.inlineKeyWidth = 24;
+   opts.keySize = stringSize;
+   for (layout = HT_AOS; layout <= HT_SOA; layout++) {
+      opts.layout = layout;
+      opts.tagged = layout == HT_SOA;
+      ht = htCreateOpts(&funcs, sizes, 4, 0.6, &opts);
+      for (i = 0; i < 200; i++) {
+         strings[i] = randomString();
+         copies[i] = copyString(strings[i]);
+         TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+      }
+      TEST_UNSIGNED(htCapacity(ht), 409);
+      for (i = 0; i < 200; i++) {
+         if (strlen(copies[i]) < 24)
+            strings[i] = copyString(copies[i]);
+         TEST_UNSIGNED(htAdd(ht, strings[i]), 2);
+      }
+      TEST_UNSIGNED(htUniqueEntries(ht), 200);
+      TEST_UNSIGNED(htTotalEntries(ht), 400);
+
+      for (i = 0; i < 200; i++) {
+         compareCalls = 0;
+         TEST_BOOLEAN(
+            (strcmp(htLookUp(ht, copies[i]).data, copies[i]) == 0), 1);
+         TEST_UNSIGNED(htLookUp(ht, copies[i]).frequency, 2);
+         if (strlen(copies[i]) < 24) {
+            TEST_UNSIGNED(compareCalls, 0);
+            free(strings[i]);
+         } else {
+            TEST_BOOLEAN((htLookUp(ht, copies[i]).data == strings[i]), 1);
+         }
+      }
+
+      entries = htToArray(ht, &size);
+      TEST_UNSIGNED(size, 200);
+      for (i = 0; i < size; i++)
+         TEST_UNSIGNED(htLookUp(ht, entries[i].data).frequency, 2);
+
+      for (i = 0; i < 200; i++)
+         free(copies[i]);
+      free(entries);
+      htDestroy(ht);
+   }
+}
+
+static void feat22() {
+   int i, engine;
+   char *string1;
+   char *strings[1000];
+   HTMetrics metrics;
+   unsigned sizes[] = {7, 17};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* growth continues past the ladder and keeps chains short */
+   for (engine = HT_CHAINED; engine <= HT_OPEN; engine++) {
+      opts.engine = engine;
+      opts.growth = HT_GROW_PRIME;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.75, &opts);
+      for (i = 0; i < 1000; i++) {
+         strings[i] = randomString();
+         /* keep 1000 unique strings */
+         if (htAdd(ht, strings[i]) > 1)
+            free(strings[i--]);
+      }
+      /* 17 -> 53 -> 193 -> 389 -> 769 -> 1543 */
+      TEST_UNSIGNED(htCapacity(ht), 1543);
+      metrics = htMetrics(ht);
+      TEST_BOOLEAN(metrics.maxChainLength < 20, 1);
+      for (i = 0; i < 1000; i++)
+         TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+      htDestroy(ht);
+
+      opts.growth = HT_GROW_POW2;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.75, &opts);
+      for (i = 0; i < 1000; i++) {
+         strings[i] = randomString();
+         /* keep 1000 unique strings */
+         if (htAdd(ht, strings[i]) > 1)
+            free(strings[i--]);
+      }
+      /* 17 -> 64 -> 128 -> ... -> 2048 */
+      TEST_UNSIGNED(htCapacity(ht), 2048);
+      for (i = 0; i < 1000; i++)
+         TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+      htDestroy(ht);
+   }
+
+   /* a load factor of 1.0 still never rehashes */
+   opts.engine = HT_CHAINED;
+   ht = htCreateOpts(&funcs, sizes, 2, 1.0, &opts);
+   for (i = 0; i < 100; i++) {
+      string1 = randomString();
+      if (htAdd(ht, string1) > 1)
+         free(string1);
+   }
+   TEST_UNSIGNED(htCapacity(ht), 7);
+   htDestroy(ht);
+}
+
+static unsigned hashUnsigned(const void *data)
+{
+   return *(const unsigned*)data * 2654435761u;
+}
+
+static int compareUnsigned(const void *a, const void *b)
+{
+   unsigned x = *(const unsigned*)a, y = *(const unsigned*)b;
+
+   return (x > y) - (x < y);
+}
+
+static unsigned* newUnsigned(unsigned value)
+{
+   unsigned *data = malloc(sizeof(unsigned));
+
+   if (data == NULL)
+   {
+      perror("newUnsigned()");
+      exit(EXIT_FAILURE);
+   }
+   *data = value;
+   return data;
+}
+
+static unsigned identityHash(const void *data)
+{
+   return *(const unsigned*)data;
+}
+
+static void feat23() {
+   unsigned i, c, *key;
+   HTMetrics metrics;
+   unsigned sizes[] = {7, 8, 1000, 65521};
+   HTFunctions funcs = {identityHash, compareUnsigned, NULL};
+   void *ht;
+
+   /* bucket indexes equal hash % capacity for prime, power of two and other
+    * capacities, including hashes near UINT_MAX */
+   for (c = 0; c < 4; c++) {
+      ht = htCreate(&funcs, sizes + c, 1, 1.0);
+      for (i = 0; i < 50; i++)
+         htAdd(ht, newUnsigned(UINT_MAX - UINT_MAX % sizes[c] - i * sizes[c]));
+      metrics = htMetrics(ht);
+      TEST_UNSIGNED(metrics.numberOfChains, 1);
+      TEST_UNSIGNED(metrics.maxChainLength, 50);
+      for (i = 0; i < 7; i++) {
+         /* UINT_MAX - UINT_MAX % cap is already there */
+         key = newUnsigned(UINT_MAX - i);
+         if (htAdd(ht, key) > 1)
+            free(key);
+      }
+      metrics = htMetrics(ht);
+      TEST_UNSIGNED(metrics.numberOfChains, 8 - (UINT_MAX % sizes[c] < 7));
+      htDestroy(ht);
+   }
+}
+
+/* Chains of a 1024 bucket table holding 1024 multiples of stride. */
+static HTMetrics stridedMetrics(unsigned (*hash)(const void *data),
+   unsigned stride)
+{
+   unsigned i;
+   HTMetrics metrics;
+   unsigned sizes[] = {1024};
+   HTFunctions funcs = {NULL, htCompareUnsigned, NULL};
+   void *ht;
+
+   funcs.hash = hash;
+   ht = htCreate(&funcs, sizes, 1, 1.0);
+   for (i = 0; i < 1024; i++)
+      htAdd(ht, newUnsigned(i * stride));
+   metrics = htMetrics(ht);
+   htDestroy(ht);
+   return metrics;
+}
+
+static void feat24() {
+   unsigned i, offset, hash;
+   unsigned *value;
+   char buffer[48];
+   const char *text = "word at a time hashing of";
+   HTMetrics metrics;
+   unsigned sizes[] = {1024};
+   HTFunctions funcs = {htHashPointer, htComparePointer, NULL};
+   void *ht;
+
+   /* alignment does not matter, length and seed do */
+   hash = htHashBytes(text, 25, 0);
+   for (offset = 1; offset < 8; offset++) {
+      memcpy(buffer + offset, text, 25);
+      TEST_UNSIGNED(htHashBytes(buffer + offset, 25, 0), hash);
+   }
+   TEST_BOOLEAN(htHashBytes(text, 25, 1) != hash, 1);
+   TEST_BOOLEAN(htHashBytes(text, 24, 0) != hash, 1);
+   memset(buffer, 0, sizeof(buffer));
+   TEST_BOOLEAN(htHashBytes(buffer, 3, 0) != htHashBytes(buffer, 4, 0), 1);
+   TEST_UNSIGNED(htHashString(text), hash);
+
+   /* strided keys all land in one bucket unless the hash mixes them */
+   metrics = stridedMetrics(identityHash, 1024);
+   TEST_UNSIGNED(metrics.numberOfChains, 1);
+   metrics = stridedMetrics(htHashUnsigned, 1024);
+   TEST_BOOLEAN(metrics.numberOfChains > 550, 1);
+   TEST_BOOLEAN(metrics.maxChainLength < 10, 1);
+
+   /* addresses as keys */
+   ht = htCreate(&funcs, sizes, 1, 0.8);
+   value = newUnsigned(0);
+   TEST_UNSIGNED(htAdd(ht, value), 1);
+   TEST_UNSIGNED(htAdd(ht, value), 2);
+   TEST_BOOLEAN((htLookUp(ht, value).data == value), 1);
+   TEST_BOOLEAN((htLookUp(ht, &i).data == NULL), 1);
+   htDestroy(ht);
+   TEST_SIGNED(htComparePointer(buffer, buffer + 1), -1);
+   TEST_SIGNED(htComparePointer(buffer + 1, buffer), 1);
+   TEST_SIGNED(htComparePointer(buffer, buffer), 0);
+}
+
+/* 64 bit hash whose low half is the same for all data */
+static unsigned long lowCollisionHash64(const void *data)
+{
+   return (unsigned long)htHashString(data) << 16 << 16 | 7;
+}
+
+static void feat25() {
+   int i, engine;
+   char *strings[300];
+   char *string1 = nonRandomString();
+   unsigned sizes[] = {101, 409, 1021};
+   HTFunctions funcs = {NULL, countingCompare, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* the high half rejects other data, also after rehashing */
+   opts.hash64 = lowCollisionHash64;
+   for (engine = 0; engine < 4; engine++) {
+      opts.engine = engine ? HT_OPEN : HT_CHAINED;
+      opts.rehashStep = engine ? 0 : 8;
+      opts.tagged = engine > 1;
+      opts.layout = engine == 3 ? HT_SOA : HT_AOS;
+      ht = htCreateOpts(&funcs, sizes, 3, 0.5, &opts);
+      for (i = 0; i < 300; i++) {
+         strings[i] = randomString();
+         /* keep 300 unique strings */
+         if (htLookUp(ht, strings[i]).data != NULL)
+            free(strings[i--]);
+         else
+            TEST_UNSIGNED(htAdd(ht, strings[i]), 1);
+      }
+      TEST_UNSIGNED(htCapacity(ht), 1021);
+      compareCalls = 0;
+      for (i = 0; i < 300; i++) {
+         TEST_BOOLEAN((htLookUp(ht, strings[i]).data == strings[i]), 1);
+         TEST_UNSIGNED(htAdd(ht, strings[i]), 2);
+      }
+      TEST_BOOLEAN((htLookUp(ht, string1).data == NULL), 1);
+      /* one compare per successful search only */
+      if (sizeof(unsigned long) > 4)
+         TEST_UNSIGNED(compareCalls, 600);
+      htDestroy(ht);
+   }
+   free(string1);
+}
+
+static void feat26() {
+   int config;
+   unsigned size;
+   char *string1;
+   const char *text = "the cat saw the other cat and then the theatre";
+   HTEntry entry, *entries;
+   unsigned sizes[] = {3, 11};
+   HTFunctions funcs = {htHashString, htCompareString, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* slices into one buffer share entries with regular strings */
+   opts.hashBytes = htHashSlice;
+   for (config = 0; config < 4; config++) {
+      opts.engine = config ? HT_OPEN : HT_CHAINED;
+      opts.rehashStep = config ? 0 : 1;
+      opts.tagged = config == 2;
+      opts.inlineKeyWidth = (config == 3) ? 6 : 0;
+      opts.keySize = (config == 3) ? stringSize : NULL;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.5, &opts);
+      TEST_UNSIGNED(htAddSlice(ht, text, 3), 1);
+      TEST_UNSIGNED(htAddSlice(ht, text + 4, 3), 1);
+      TEST_UNSIGNED(htAddSlice(ht, text + 12, 3), 2);
+      TEST_UNSIGNED(htAddSlice(ht, text + 16, 5), 1);
+      TEST_UNSIGNED(htAddSlice(ht, text + 22, 3), 2);
+      TEST_UNSIGNED(htAddSlice(ht, text + 39, 7), 1);
+      string1 = copyString("other");
+      TEST_UNSIGNED(htAdd(ht, string1), 2);
+      free(string1);
+      TEST_UNSIGNED(htAdd(ht, copyString("saw")), 1);
+      TEST_UNSIGNED(htUniqueEntries(ht), 5);
+      TEST_UNSIGNED(htTotalEntries(ht), 8);
+
+      entry = htLookUpSlice(ht, text + 35, 3);
+      TEST_UNSIGNED(entry.frequency, 2);
+      TEST_BOOLEAN((strcmp(entry.data, "the") == 0), 1);
+      TEST_UNSIGNED(htLookUpSlice(ht, text + 8, 3).frequency, 1);
+      TEST_UNSIGNED(htLookUpSlice(ht, text + 39, 7).frequency, 1);
+      /* prefixes and extensions of stored strings are different keys */
+      TEST_BOOLEAN((htLookUpSlice(ht, text, 2).data == NULL), 1);
+      TEST_UNSIGNED(htLookUpSlice(ht, text + 39, 3).frequency, 2);
+      TEST_BOOLEAN((htLookUpSlice(ht, text + 39, 4).data == NULL), 1);
+      TEST_BOOLEAN((htLookUpSlice(ht, text + 16, 4).data == NULL), 1);
+      TEST_BOOLEAN((htLookUpSlice(ht, text + 30, 4).data == NULL), 1);
+      TEST_BOOLEAN((htLookUpSlice(ht, text, 0).data == NULL), 1);
+      TEST_UNSIGNED(htAddSlice(ht, text, 0), 1);
+      TEST_UNSIGNED(htLookUp(ht, "").frequency, 1);
+
+      entries = htToArray(ht, &size);
+      TEST_UNSIGNED(size, 6);
+      free(entries);
+      htDestroy(ht);
+   }
+}
+
+static unsigned equalCalls = 0;
+
+static int countingEqual(const void *a, const void *b)
+{
+   equalCalls++;
+   return strcmp(a, b) == 0;
+}
+
+static void feat27() {
+   int i, config;
+   char *strings[100];
+   char *string1;
+   unsigned sizes[] = {7, 31, 101};
+   HTFunctions funcs = {hashString, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* with an equality test the table never needs a compare */
+   opts.equal = countingEqual;
+   for (config = 0; config < 3; config++) {
+      opts.engine = config ? HT_OPEN : HT_CHAINED;
+      opts.rehashStep = config ? 0 : 2;
+      opts.tagged = config == 2;
+      ht = htCreateOpts(&funcs, sizes, 3, 0.6, &opts);
+      for (i = 0; i < 100; i++) {
+         strings[i] = randomString();
+         /* keep 100 unique strings */
+         if (htAdd(ht, strings[i]) > 1)
+            free(strings[i--]);
+      }
+      equalCalls = 0;
+      for (i = 0; i < 100; i++) {
+         string1 = copyString(strings[i]);
+         TEST_UNSIGNED(htAdd(ht, string1), 2);
+         TEST_BOOLEAN((htLookUp(ht, string1).data == strings[i]), 1);
+         free(string1);
+      }
+      TEST_UNSIGNED(equalCalls, 200);
+      TEST_UNSIGNED(htUniqueEntries(ht), 100);
+      htDestroy(ht);
+   }
+}
+
+HT_DEFINE(UIntTable, unsigned, htGenMix32, HT_GEN_EQUAL)
+
+typedef struct
+{
+   int x;
+   int y;
+}  Point;
+
+#define POINT_HASH(_POINT) htGenMix32((unsigned)(_POINT).x * 31u + \
+   (unsigned)(_POINT).y)
+#define POINT_EQUAL(_POINT1, _POINT2) \
+   ((_POINT1).x == (_POINT2).x && (_POINT1).y == (_POINT2).y)
+
+HT_DEFINE(PointTable, Point, POINT_HASH, POINT_EQUAL)
+
+static void feat28() {
+   unsigned i;
+   UIntTable ints;
+   PointTable points;
+   Point point;
+
+   /* keys by value, growing from the smallest capacity */
+   UIntTableInit(&ints, 1);
+   TEST_UNSIGNED(ints.cap, 8);
+   for (i = 0; i < 10000; i++)
+      TEST_UNSIGNED(UIntTableAdd(&ints, i * 1024), 1);
+   for (i = 0; i < 10000; i += 2)
+      TEST_UNSIGNED(UIntTableAdd(&ints, i * 1024), 2);
+   TEST_UNSIGNED(ints.unique, 10000);
+   TEST_UNSIGNED(ints.total, 15000);
+   TEST_UNSIGNED(ints.cap, 16384);
+   for (i = 0; i < 10000; i++)
+      TEST_UNSIGNED(UIntTableLookUp(&ints, i * 1024), 2 - i % 2);
+   TEST_UNSIGNED(UIntTableLookUp(&ints, 1), 0);
+   TEST_BOOLEAN((UIntTableFind(&ints, 1024)->key == 1024), 1);
+   UIntTableDestroy(&ints);
+
+   PointTableInit(&points, 100);
+   for (point.x = -10; point.x < 10; point.x++) {
+      for (point.y = -10; point.y < 10; point.y++)
+         PointTableAdd(&points, point);
+   }
+   point.x = 3;
+   point.y = -4;
+   TEST_UNSIGNED(PointTableAdd(&points, point), 2);
+   TEST_UNSIGNED(points.unique, 400);
+   point.y = 10;
+   TEST_UNSIGNED(PointTableLookUp(&points, point), 0);
+   PointTableDestroy(&points);
+}
+
+static void feat29() {
+   unsigned i, config, freqs[300];
+   unsigned *keys[300], *seqKeys[300], *probes[200];
+   unsigned sizes[] = {7, 31, 101, 401};
+   HTFunctions funcs = {hashUnsigned, compareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   HTEntry entries[200], entry;
+   void *ht, *seq;
+
+   /* batches behave like the calls they replace, duplicates included */
+   for (config = 0; config < 4; config++) {
+      opts.engine = config ? HT_OPEN : HT_CHAINED;
+      opts.rehashStep = config ? 0 : 2;
+      opts.tagged = config == 2;
+      opts.layout = (config == 3) ? HT_SOA : HT_AOS;
+      ht = htCreateOpts(&funcs, sizes, 4, 0.7, &opts);
+      seq = htCreateOpts(&funcs, sizes, 4, 0.7, &opts);
+      for (i = 0; i < 300; i++) {
+         keys[i] = newUnsigned(i % 150);
+         seqKeys[i] = newUnsigned(i % 150);
+      }
+      htAddBatch(ht, (void**)keys, 300, freqs);
+      for (i = 0; i < 300; i++) {
+         TEST_UNSIGNED(freqs[i], htAdd(seq, seqKeys[i]));
+         TEST_UNSIGNED(freqs[i], 1 + (i >= 150));
+      }
+      TEST_UNSIGNED(htUniqueEntries(ht), 150);
+      TEST_UNSIGNED(htTotalEntries(ht), 300);
+      TEST_UNSIGNED(htCapacity(ht), htCapacity(seq));
+
+      /* half of the probes miss */
+      for (i = 0; i < 200; i++)
+         probes[i] = newUnsigned(i + 50);
+      htLookUpBatch(ht, (void**)probes, 200, entries);
+      for (i = 0; i < 200; i++) {
+         entry = htLookUp(ht, probes[i]);
+         TEST_BOOLEAN(entries[i].data == entry.data, 1);
+         TEST_UNSIGNED(entries[i].frequency, entry.frequency);
+         TEST_UNSIGNED(entries[i].frequency, (i < 100) ? 2 : 0);
+         if (i < 100)
+            TEST_BOOLEAN(entries[i].data == keys[i + 50], 1);
+      }
+      htAddBatch(ht, (void**)probes, 0, NULL);
+      TEST_UNSIGNED(htTotalEntries(ht), 300);
+
+      for (i = 0; i < 200; i++)
+         free(probes[i]);
+      for (i = 150; i < 300; i++) {
+         free(keys[i]);
+         free(seqKeys[i]);
+      }
+      htDestroy(ht);
+      htDestroy(seq);
+   }
+}
+
+static void feat30() {
+   unsigned i, op, key, config, unique, total, counts[500];
+   char name[16], *copy;
+   unsigned sizes[] = {7, 31};
+   HTFunctions funcs = {htHashString, htCompareString, NULL};
+   HTOptions opts;
+   HTEntry entry;
+   void *ht;
+
+   /* random adds, decrements and removals checked against plain counters,
+    * with keys short enough to be inline for "k0" to "k99" */
+   for (config = 0; config < 6; config++) {
+      opts = htDefaultOptions();
+      opts.growth = HT_GROW_POW2;
+      opts.engine = (config < 2) ? HT_CHAINED : HT_OPEN;
+      opts.rehashStep = (config == 1) ? 2 : 0;
+      opts.tagged = config == 3 || config == 5;
+      opts.layout = (config == 4) ? HT_SOA : HT_AOS;
+      opts.hash64 = (config == 4) ? htHashString64 : NULL;
+      opts.inlineKeyWidth = (config == 5) ? 4 : 0;
+      opts.keySize = stringSize;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.7, &opts);
+      memset(counts, 0, sizeof(counts));
+      unique = total = 0;
+      for (i = 0; i < 20000; i++) {
+         key = rand() % 500;
+         sprintf(name, "k%u", key);
+         op = rand() % 4;
+         if (op < 2) {
+            copy = copyString(name);
+            if (htAdd(ht, copy) > 1)
+               free(copy);
+            unique += counts[key]++ == 0;
+            total++;
+         } else if (op == 2) {
+            TEST_UNSIGNED(htDecrement(ht, name),
+               counts[key] ? counts[key] - 1 : 0);
+            unique -= counts[key] == 1;
+            total -= counts[key] != 0;
+            counts[key] -= counts[key] != 0;
+         } else if (rand() % 4 == 0) {
+            /* through the table's own pointer */
+            entry = htLookUp(ht, name);
+            TEST_UNSIGNED(entry.frequency, counts[key]);
+            if (entry.data != NULL) {
+               TEST_UNSIGNED(htRemove(ht, entry.data), counts[key]);
+            } else {
+               TEST_UNSIGNED(htRemove(ht, name), counts[key]);
+            }
+            unique -= counts[key] != 0;
+            total -= counts[key];
+            counts[key] = 0;
+         }
+         TEST_UNSIGNED(htUniqueEntries(ht), unique);
+         TEST_UNSIGNED(htTotalEntries(ht), total);
+      }
+      for (key = 0; key < 500; key++) {
+         sprintf(name, "k%u", key);
+         TEST_UNSIGNED(htLookUp(ht, name).frequency, counts[key]);
+         TEST_UNSIGNED(htRemove(ht, name), counts[key]);
+         TEST_UNSIGNED(htLookUp(ht, name).frequency, 0);
+      }
+      /* nothing is left behind */
+      TEST_UNSIGNED(htUniqueEntries(ht), 0);
+      TEST_UNSIGNED(htTotalEntries(ht), 0);
+      TEST_UNSIGNED(htMetrics(ht).numberOfChains, 0);
+      TEST_UNSIGNED(htRemove(ht, name), 0);
+      TEST_UNSIGNED(htDecrement(ht, name), 0);
+      htDestroy(ht);
+   }
+}
+
+static void feat31() {
+   unsigned i, config, grown, cap, *keys[3000];
+   unsigned sizes[] = {7, 31, 127, 509};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   opts.growth = HT_GROW_POW2;
+   for (config = 0; config < 6; config++) {
+      opts.engine = (config % 3) ? HT_OPEN : HT_CHAINED;
+      opts.tagged = config % 3 == 2;
+      opts.rehashStep = (config == 3) ? 4 : 0;
+      opts.shrinkLoadFactor = (config > 2) ? 0.1 : 0;
+      ht = htCreateOpts(&funcs, sizes, 4, 0.7, &opts);
+      for (i = 0; i < 3000; i++)
+         htAdd(ht, keys[i] = newUnsigned(i));
+      grown = htCapacity(ht);
+      TEST_UNSIGNED(grown, 8192);
+
+      if (config <= 2) {
+         /* shrinking explicitly, first past the ladder then onto it */
+         for (i = 600; i < 3000; i++)
+            htRemove(ht, keys[i]);
+         TEST_UNSIGNED(htCapacity(ht), 8192);
+         htShrinkToFit(ht);
+         TEST_UNSIGNED(htCapacity(ht), 1024);
+         for (i = 100; i < 600; i++)
+            htRemove(ht, keys[i]);
+         htShrinkToFit(ht);
+         TEST_UNSIGNED(htCapacity(ht), 509);
+         htShrinkToFit(ht);
+         TEST_UNSIGNED(htCapacity(ht), 509);
+      } else {
+         /* the low-water mark follows the removals down */
+         for (i = 2999; i >= 100; i--) {
+            cap = htCapacity(ht);
+            htRemove(ht, keys[i]);
+            TEST_BOOLEAN(htCapacity(ht) <= cap, 1);
+            TEST_BOOLEAN(htCapacity(ht) == 7 ||
+               htUniqueEntries(ht) >= 0.1 * htCapacity(ht), 1);
+         }
+         TEST_BOOLEAN(htCapacity(ht) < 2048, 1);
+      }
+      for (i = 0; i < 100; i++) {
+         TEST_UNSIGNED(htLookUp(ht, keys[i]).frequency, 1);
+         TEST_BOOLEAN(htLookUp(ht, keys[i]).data == keys[i], 1);
+      }
+      TEST_UNSIGNED(htUniqueEntries(ht), 100);
+      TEST_UNSIGNED(htTotalEntries(ht), 100);
+
+      /* emptied tables go back to the first size and climb as before */
+      for (i = 0; i < 100; i++)
+         htRemove(ht, keys[i]);
+      htShrinkToFit(ht);
+      TEST_UNSIGNED(htCapacity(ht), 7);
+      for (i = 0; i < 3000; i++)
+         htAdd(ht, newUnsigned(i));
+      TEST_UNSIGNED(htCapacity(ht), grown);
+      htDestroy(ht);
+   }
+}
+
+static void feat32() {
+   unsigned i, config, *key;
+   unsigned sizes[] = {7, 31, 127, 509};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   for (config = 0; config < 4; config++) {
+      opts.engine = (config % 2) ? HT_OPEN : HT_CHAINED;
+      opts.rehashStep = (config == 2) ? 4 : 0;
+      opts.growth = (config == 3) ? HT_GROW_LADDER : HT_GROW_POW2;
+      ht = htCreateOpts(&funcs, sizes, 4, 0.7, &opts);
+      for (i = 0; i < 20; i++)
+         htAdd(ht, newUnsigned(i));
+      htReserve(ht, 3000);
+      TEST_UNSIGNED(htCapacity(ht), (config == 3) ? 509 : 8192);
+      /* no rehash on the way: the capacity never moves */
+      for (i = 0; i < 3000; i++) {
+         key = newUnsigned(i);
+         if (htAdd(ht, key) > 1)
+            free(key);
+         if (config != 3)
+            TEST_UNSIGNED(htCapacity(ht), 8192);
+      }
+      TEST_UNSIGNED(htUniqueEntries(ht), 3000);
+      TEST_UNSIGNED(htTotalEntries(ht), 3020);
+      for (i = 0; i < 3000; i++) {
+         TEST_UNSIGNED(htLookUp(ht, &i).frequency, 1 + (i < 20));
+      }
+      /* already large enough */
+      i = htCapacity(ht);
+      htReserve(ht, 100);
+      TEST_UNSIGNED(htCapacity(ht), i);
+      htDestroy(ht);
+   }
+
+   /* a reservation on the ladder stops at the first size that fits */
+   ht = htCreateOpts(&funcs, sizes, 4, 0.7, NULL);
+   htReserve(ht, 80);
+   TEST_UNSIGNED(htCapacity(ht), 127);
+   htReserve(ht, 88);
+   TEST_UNSIGNED(htCapacity(ht), 127);
+   htReserve(ht, 89);
+   TEST_UNSIGNED(htCapacity(ht), 509);
+   htDestroy(ht);
+}
+
+static int countVisit(HTEntry entry, void *context)
+{
+   /* stops after ten entries */
+   unsigned *visited = context;
+   TEST_BOOLEAN(entry.data != NULL, 1);
+   return ++(*visited) == 10;
+}
+
+static void feat33() {
+   unsigned i, config, size, n, total, visited;
+   char *string;
+   unsigned sizes[] = {100, 1000};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   HTOptions opts;
+   HTIterator it;
+   HTEntry entry, *entries;
+   void *ht;
+
+   for (config = 0; config < 5; config++) {
+      opts = htDefaultOptions();
+      opts.engine = (config < 2) ? HT_CHAINED : HT_OPEN;
+      /* still migrating when the walk starts */
+      opts.rehashStep = (config == 1);
+      opts.layout = (config == 3) ? HT_SOA : HT_AOS;
+      opts.tagged = config == 4;
+      opts.inlineKeyWidth = (config == 4) ? 8 : 0;
+      opts.keySize = stringSize;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.7, &opts);
+      htIterInit(ht, &it);
+      TEST_BOOLEAN(htIterNext(&it, &entry), 0);
+      for (i = 0; i < 100; i++) {
+         string = randomString();
+         if (htAdd(ht, string) > 1)
+            free(string);
+      }
+      for (i = 0; i < 50; i++) {
+         htIterInit(ht, &it);
+         htIterNext(&it, &entry);
+         string = copyString(entry.data);
+         TEST_BOOLEAN(htAdd(ht, string) > 1, 1);
+         free(string);
+      }
+
+      /* the walk sees what htToArray copies, in the same order */
+      entries = htToArray(ht, &size);
+      TEST_UNSIGNED(size, htUniqueEntries(ht));
+      htIterInit(ht, &it);
+      for (n = 0, total = 0; htIterNext(&it, &entry); n++) {
+         TEST_BOOLEAN(n < size && entry.data == entries[n].data, 1);
+         TEST_UNSIGNED(entry.frequency, entries[n].frequency);
+         total += entry.frequency;
+      }
+      TEST_UNSIGNED(n, htUniqueEntries(ht));
+      TEST_UNSIGNED(total, htTotalEntries(ht));
+      TEST_BOOLEAN(htIterNext(&it, &entry), 0);
+      free(entries);
+
+      visited = 0;
+      TEST_UNSIGNED(htForEach(ht, countVisit, &visited), 10);
+      TEST_UNSIGNED(visited, 10);
+      htDestroy(ht);
+   }
+}
+
+static int compareFrequency(const void *a, const void *b)
+{
+   /* descending */
+   unsigned x = ((const HTEntry*)a)->frequency;
+   unsigned y = ((const HTEntry*)b)->frequency;
+   return (x < y) - (x > y);
+}
+
+static void feat34() {
+   unsigned i, j, n, config, size, *key, threads[] = {0, 3, 8};
+   unsigned sizes[] = {31, 127, 509};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   HTEntry *sorted, top[250];
+   void *ht;
+
+   for (config = 0; config < 3; config++) {
+      opts.engine = (config == 2) ? HT_OPEN : HT_CHAINED;
+      opts.rehashStep = (config == 1);
+      ht = htCreateOpts(&funcs, sizes, 3, 0.7, &opts);
+      n = 0;
+      TEST_UNSIGNED(htTopK(ht, 10, top), 0);
+      for (i = 0; i < 3000; i++) {
+         key = newUnsigned(rand() % 200);
+         if (htAdd(ht, key) > 1)
+            free(key);
+      }
+
+      /* the frequencies qsort puts first, with any of the tied entries */
+      sorted = htToArray(ht, &size);
+      qsort(sorted, size, sizeof(HTEntry), compareFrequency);
+      for (j = 0; j < 3; j++) {
+         TEST_UNSIGNED(htTopKParallel(ht, 20, top, threads[j]), 20);
+         for (i = 0; i < 20; i++) {
+            TEST_UNSIGNED(top[i].frequency, sorted[i].frequency);
+            TEST_UNSIGNED(htLookUp(ht, top[i].data).frequency,
+               top[i].frequency);
+         }
+         n = htTopKParallel(ht, 250, top, threads[j]);
+         TEST_UNSIGNED(n, size);
+         for (i = 0; i < n; i++)
+            TEST_UNSIGNED(top[i].frequency, sorted[i].frequency);
+      }
+      TEST_UNSIGNED(htTopK(ht, 0, top), 0);
+      free(sorted);
+      htDestroy(ht);
+   }
+}
+
+/* what one thread of feat35 works on */
+typedef struct
+{
+   void *ht;
+   unsigned stride;
+   unsigned errors;
+}  StripeWork;
+
+#define STRIPE_KEYS 4999
+
+static void* stripeAdder(void *arg)
+{
+   /* every key once, in an order of its own */
+   StripeWork *work = arg;
+   unsigned i, value, *key;
+   for (i = 0; i < STRIPE_KEYS; i++) {
+      value = i * work->stride % STRIPE_KEYS;
+      key = newUnsigned(value);
+      if (htAdd(work->ht, key) > 1)
+         free(key);
+      if (htLookUp(work->ht, &value).frequency == 0)
+         work->errors++;
+   }
+   return NULL;
+}
+
+static void* stripeDecrementer(void *arg)
+{
+   StripeWork *work = arg;
+   unsigned i, key;
+   for (i = 0; i < STRIPE_KEYS; i++) {
+      key = i * work->stride % STRIPE_KEYS;
+      if (htDecrement(work->ht, &key) >= 8)
+         work->errors++;
+   }
+   return NULL;
+}
+
+static void feat35() {
+   unsigned i, t, phase;
+   unsigned sizes[] = {7};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   StripeWork work[8];
+   pthread_t ids[8];
+   void *ht;
+
+   /* eight threads add every key while the table grows from 7 buckets,
+    * then take them all away again */
+   opts.stripes = 16;
+   opts.growth = HT_GROW_POW2;
+   ht = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+   for (phase = 0; phase < 2; phase++) {
+      for (t = 0; t < 8; t++) {
+         work[t].ht = ht;
+         work[t].stride = 1 + 611 * t;
+         work[t].errors = 0;
+         TEST_BOOLEAN(pthread_create(ids + t, NULL,
+            phase ? stripeDecrementer : stripeAdder, work + t) == 0, 1);
+      }
+      for (t = 0; t < 8; t++) {
+         pthread_join(ids[t], NULL);
+         TEST_UNSIGNED(work[t].errors, 0);
+      }
+      TEST_UNSIGNED(htUniqueEntries(ht), phase ? 0 : STRIPE_KEYS);
+      TEST_UNSIGNED(htTotalEntries(ht), phase ? 0 : 8 * STRIPE_KEYS);
+      for (i = 0; i < STRIPE_KEYS; i++) {
+         TEST_UNSIGNED(htLookUp(ht, &i).frequency, phase ? 0 : 8);
+      }
+   }
+   TEST_BOOLEAN(htCapacity(ht) >= STRIPE_KEYS / 0.75, 1);
+   htDestroy(ht);
+}
+
+static void feat36() {
+   unsigned i, t, config, seen;
+   unsigned sizes[] = {7, 31, 127};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   StripeWork work[8];
+   pthread_t ids[8];
+   HTIterator it;
+   HTEntry entry;
+   void *ht;
+
+   /* eight threads add every key of a lock-free table that starts at 7
+    * slots, growing by powers of two or, past a short ladder with a load
+    * factor of 1.0, only when completely full */
+   opts.engine = HT_ATOMIC;
+   for (config = 0; config < 2; config++) {
+      opts.growth = config ? HT_GROW_LADDER : HT_GROW_POW2;
+      ht = htCreateOpts(&funcs, sizes, config ? 3 : 1, config ? 1.0 : 0.75,
+         &opts);
+      for (t = 0; t < 8; t++) {
+         work[t].ht = ht;
+         work[t].stride = 1 + 611 * t;
+         work[t].errors = 0;
+         TEST_BOOLEAN(pthread_create(ids + t, NULL, stripeAdder,
+            work + t) == 0, 1);
+      }
+      for (t = 0; t < 8; t++) {
+         pthread_join(ids[t], NULL);
+         TEST_UNSIGNED(work[t].errors, 0);
+      }
+      TEST_UNSIGNED(htUniqueEntries(ht), STRIPE_KEYS);
+      TEST_UNSIGNED(htTotalEntries(ht), 8 * STRIPE_KEYS);
+      TEST_BOOLEAN(htCapacity(ht) > STRIPE_KEYS, 1);
+      for (i = 0; i < STRIPE_KEYS; i++) {
+         TEST_UNSIGNED(htLookUp(ht, &i).frequency, 8);
+      }
+      i = STRIPE_KEYS;
+      TEST_UNSIGNED(htLookUp(ht, &i).frequency, 0);
+      seen = 0;
+      htIterInit(ht, &it);
+      while (htIterNext(&it, &entry))
+         seen += entry.frequency;
+      TEST_UNSIGNED(seen, 8 * STRIPE_KEYS);
+      TEST_BOOLEAN(htMetrics(ht).maxChainLength >= 1, 1);
+      htDestroy(ht);
+   }
+}
+
+static HTOptions mergeOptions(unsigned config)
+{
+   /* the engines feat37 merges, all with their own hashing of strings */
+   HTOptions opts = htDefaultOptions();
+   opts.growth = HT_GROW_POW2;
+   opts.keySize = stringSize;
+   opts.engine = (config == 2 || config == 3) ? HT_OPEN :
+      (config == 4) ? HT_ATOMIC : HT_CHAINED;
+   opts.rehashStep = (config == 1) ? 2 : 0;
+   opts.tagged = config == 2;
+   opts.layout = (config == 3) ? HT_SOA : HT_AOS;
+   opts.hash64 = (config == 3) ? htHashString64 : NULL;
+   opts.stripes = (config == 5) ? 8 : 0;
+   return opts;
+}
+
+static void feat37() {
+   unsigned i, key, config, shard, counts[300];
+   char name[16], *copy;
+   unsigned sizes[] = {7, 31};
+   HTFunctions funcs = {htHashString, htCompareString, NULL};
+   HTOptions opts, otherOpts;
+   void *shards[5], *ht, *other;
+
+   /* five shards counting overlapping keys merged as a tree, then moved
+    * into a table of another engine storing short keys inline */
+   for (config = 0; config < 6; config++) {
+      opts = mergeOptions(config);
+      memset(counts, 0, sizeof(counts));
+      for (shard = 0; shard < 5; shard++) {
+         shards[shard] = htCreateOpts(&funcs, sizes, 2, 0.7, &opts);
+         for (i = 0; i < 400 * shard; i++) {
+            key = rand() % 300;
+            sprintf(name, "k%u", key);
+            copy = copyString(name);
+            if (htAdd(shards[shard], copy) > 1)
+               free(copy);
+            counts[key]++;
+         }
+      }
+      ht = htMergeParallel(shards, 5);
+      TEST_UNSIGNED(htTotalEntries(ht), 400 * (1 + 2 + 3 + 4));
+      for (key = 0; key < 300; key++) {
+         sprintf(name, "k%u", key);
+         TEST_UNSIGNED(htLookUp(ht, name).frequency, counts[key]);
+      }
+
+      otherOpts = htDefaultOptions();
+      otherOpts.keySize = stringSize;
+      if (config == 3) {
+         otherOpts.hash64 = htHashString64;
+      } else {
+         otherOpts.engine = HT_OPEN;
+         otherOpts.inlineKeyWidth = 4;
+      }
+      other = htCreateOpts(&funcs, sizes, 2, 0.7, &otherOpts);
+      copy = copyString("k0");
+      htAdd(other, copy);
+      htMerge(other, ht);
+      TEST_UNSIGNED(htTotalEntries(other), 400 * (1 + 2 + 3 + 4) + 1);
+      for (key = 0; key < 300; key++) {
+         sprintf(name, "k%u", key);
+         TEST_UNSIGNED(htLookUp(other, name).frequency,
+            counts[key] + (key == 0));
+      }
+      htDestroy(other);
+   }
+   /* a lone table is its own merge */
+   ht = htCreateOpts(&funcs, sizes, 2, 0.7, &opts);
+   TEST_BOOLEAN(htMergeParallel(&ht, 1) == ht, 1);
+   htDestroy(ht);
+}
+
+/* 64 bit hash of an unsigned, the low half being htHashUnsigned */
+static unsigned long hashUnsigned64(const void *data)
+{
+   return (unsigned long)htMix32(*(const unsigned*)data ^ 0x9E3779B9U)
+      << 16 << 16 | htHashUnsigned(data);
+}
+
+static void feat38() {
+   unsigned i, t, config, *key;
+   unsigned sizes[] = {7, 40000};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   HTMetrics met, serialMet;
+   StripeWork work[8];
+   pthread_t ids[8];
+   void *ht, *serial;
+
+   /* tables rehashing past 40000 buckets on four threads hold what the
+    * same adds leave in a table rehashing on one */
+   opts.growth = HT_GROW_POW2;
+   for (config = 0; config < 3; config++) {
+      opts.hash64 = (config == 1) ? hashUnsigned64 : NULL;
+      opts.stripes = (config == 2) ? 16 : 0;
+      opts.rehashThreads = 1;
+      serial = htCreateOpts(&funcs, sizes, 2, 0.75, &opts);
+      opts.rehashThreads = 4;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.75, &opts);
+      for (i = 0; i < 200000; i++) {
+         key = newUnsigned(htMix32(i) % 150000);
+         if (htAdd(serial, key) > 1)
+            free(key);
+      }
+      if (config == 2) {
+         /* threads adding meanwhile wait for the rehash */
+         for (t = 0; t < 8; t++) {
+            work[t].ht = ht;
+            work[t].stride = 1 + 611 * t;
+            work[t].errors = 0;
+            TEST_BOOLEAN(pthread_create(ids + t, NULL, stripeAdder,
+               work + t) == 0, 1);
+         }
+      }
+      for (i = 0; i < 200000; i++) {
+         key = newUnsigned(htMix32(i) % 150000);
+         if (htAdd(ht, key) > 1)
+            free(key);
+      }
+      if (config == 2) {
+         for (t = 0; t < 8; t++) {
+            pthread_join(ids[t], NULL);
+            TEST_UNSIGNED(work[t].errors, 0);
+         }
+         for (t = 0; t < 8; t++) {
+            work[t].ht = serial;
+            stripeAdder(work + t);
+         }
+      }
+      TEST_BOOLEAN(htCapacity(ht) > 2 * 16384, 1);
+      TEST_UNSIGNED(htCapacity(ht), htCapacity(serial));
+      TEST_UNSIGNED(htUniqueEntries(ht), htUniqueEntries(serial));
+      TEST_UNSIGNED(htTotalEntries(ht), htTotalEntries(serial));
+      for (i = 0; i < 150000; i++) {
+         TEST_UNSIGNED(htLookUp(ht, &i).frequency,
+            htLookUp(serial, &i).frequency);
+      }
+      met = htMetrics(ht);
+      serialMet = htMetrics(serial);
+      TEST_UNSIGNED(met.numberOfChains, serialMet.numberOfChains);
+      TEST_UNSIGNED(met.maxChainLength, serialMet.maxChainLength);
+      htDestroy(ht);
+      htDestroy(serial);
+   }
+}
+
+static void stripeRun(StripeWork work[], unsigned threads,
+   void* (*fn)(void *arg))
+{
+   /* runs fn on threads threads at once, each with work of its own */
+   unsigned t;
+   pthread_t ids[8];
+   for (t = 0; t < threads; t++) {
+      work[t].stride = 1 + 611 * t;
+      work[t].errors = 0;
+      TEST_BOOLEAN(pthread_create(ids + t, NULL, fn, work + t) == 0, 1);
+   }
+   for (t = 0; t < threads; t++) {
+      pthread_join(ids[t], NULL);
+      TEST_UNSIGNED(work[t].errors, 0);
+   }
+}
+
+static void feat39() {
+   unsigned i, t;
+   unsigned sizes[] = {11, 1009, 100003};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   StripeWork work[4];
+   void *ht;
+
+   /* threads keep finding the right stripe after htReserve and
+    * htShrinkToFit change the capacity of a striped table */
+   opts.stripes = 8;
+   ht = htCreateOpts(&funcs, sizes, 3, 0.75, &opts);
+   for (t = 0; t < 4; t++)
+      work[t].ht = ht;
+   htReserve(ht, 50000);
+   TEST_UNSIGNED(htCapacity(ht), 100003);
+   stripeRun(work, 4, stripeAdder);
+   TEST_UNSIGNED(htUniqueEntries(ht), STRIPE_KEYS);
+   TEST_UNSIGNED(htTotalEntries(ht), 4 * STRIPE_KEYS);
+   stripeRun(work, 4, stripeDecrementer);
+   TEST_UNSIGNED(htUniqueEntries(ht), 0);
+   htShrinkToFit(ht);
+   TEST_UNSIGNED(htCapacity(ht), 11);
+   stripeRun(work, 4, stripeAdder);
+   TEST_UNSIGNED(htTotalEntries(ht), 4 * STRIPE_KEYS);
+   for (i = 0; i < STRIPE_KEYS; i++) {
+      TEST_UNSIGNED(htLookUp(ht, &i).frequency, 4);
+   }
+   htDestroy(ht);
+}
+
+static void feat40() {
+   unsigned i;
+   size_t before;
+   unsigned sizes[] = {1024};
+   HTFunctions funcs = {htHashUnsigned, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   /* shrinking gives the bucket memory of the larger table back */
+   opts.growth = HT_GROW_POW2;
+   ht = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+   for (i = 0; i < 200000; i++)
+      htAdd(ht, newUnsigned(i));
+   before = htArenaBytes(ht);
+   for (i = 100; i < 200000; i++)
+      htRemove(ht, &i);
+   TEST_BOOLEAN(htArenaBytes(ht) == before, 1);
+   htShrinkToFit(ht);
+   TEST_UNSIGNED(htCapacity(ht), 1024);
+   TEST_BOOLEAN(htArenaBytes(ht) > 0, 1);
+   TEST_BOOLEAN(htArenaBytes(ht) * 100 < before, 1);
+   for (i = 0; i < 200; i++) {
+      TEST_UNSIGNED(htLookUp(ht, &i).frequency, i < 100);
+   }
+   for (i = 100; i < 200; i++)
+      htAdd(ht, newUnsigned(i));
+   TEST_UNSIGNED(htUniqueEntries(ht), 200);
+   htDestroy(ht);
+
+   /* open addressing has no bucket allocator */
+   opts.engine = HT_OPEN;
+   ht = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+   htAdd(ht, newUnsigned(0));
+   TEST_BOOLEAN(htArenaBytes(ht) == 0, 1);
+   htDestroy(ht);
+}
+
+static void feat41() {
+   unsigned i, t;
+   unsigned sizes[] = {7};
+   HTFunctions funcs = {identityHash, htCompareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   StripeWork work[8];
+   void *ht;
+
+   /* hashes that only differ in their low bits still spread over the
+    * counters of a lock-free table, which grows when the real count says
+    * so and not sooner */
+   opts.engine = HT_ATOMIC;
+   opts.growth = HT_GROW_POW2;
+   ht = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+   for (t = 0; t < 8; t++)
+      work[t].ht = ht;
+   stripeRun(work, 8, stripeAdder);
+   TEST_UNSIGNED(htUniqueEntries(ht), STRIPE_KEYS);
+   TEST_UNSIGNED(htTotalEntries(ht), 8 * STRIPE_KEYS);
+   TEST_BOOLEAN(htCapacity(ht) * 0.75 >= STRIPE_KEYS, 1);
+   TEST_BOOLEAN(htCapacity(ht) * 0.75 < 2 * STRIPE_KEYS + 1, 1);
+   for (i = 0; i < STRIPE_KEYS; i++) {
+      TEST_UNSIGNED(htLookUp(ht, &i).frequency, 8);
+   }
+   htDestroy(ht);
+}
+
 static void cpu02() {
    unsigned i = 0;
    unsigned sizes[] = {2000000};
@@ -837,6 +2404,799 @@ static void heap01() {
    htDestroy(ht);
 }
 
+#define BENCH_WORDS 400000
+#define BENCH_VOCAB 50000
+
+/* Benchmark helper: a word count style load (every word seen about eight
+ * times) followed by lookups of present and absent words. The copies handed
+ * to htAdd are made before timing starts.
+ */
+static void benchWordCount(const char *name, HTOptions *opts,
+   char **vocab, char **absent)
+{
+   unsigned i;
+   clock_t start;
+   double addTime, hitTime, missTime;
+   char **copies = malloc(BENCH_WORDS * sizeof(char*));
+   unsigned sizes[] = {1021, 4093, 16381, 65521, 262139};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   void *ht = htCreateOpts(&funcs, sizes, 5, 0.72, opts);
+
+   if (copies == NULL)
+   {
+      perror("benchWordCount()");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < BENCH_WORDS; i++)
+      copies[i] = copyString(vocab[(i * 7919) % BENCH_VOCAB]);
+
+   start = clock();
+   for (i = 0; i < BENCH_WORDS; i++) {
+      if (htAdd(ht, copies[i]) > 1)
+         free(copies[i]);
+   }
+   addTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   start = clock();
+   for (i = 0; i < BENCH_WORDS; i++)
+      htLookUp(ht, vocab[i % BENCH_VOCAB]);
+   hitTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   start = clock();
+   for (i = 0; i < BENCH_WORDS; i++)
+      htLookUp(ht, absent[i % BENCH_VOCAB]);
+   missTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   printf("   %-10s add %.3fs  hit %.3fs  miss %.3fs\n",
+      name, addTime, hitTime, missTime);
+   free(copies);
+   htDestroy(ht);
+}
+
+static void benchFreeWords(char **words)
+{
+   int i;
+
+   for (i = 0; i < BENCH_VOCAB; i++)
+      free(words[i]);
+   free(words);
+}
+
+static char** benchWords()
+{
+   int i;
+   char **words = malloc(BENCH_VOCAB * sizeof(char*));
+
+   if (words == NULL)
+   {
+      perror("benchWords()");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < BENCH_VOCAB; i++)
+      words[i] = randomString();
+   return words;
+}
+
+/* Compares the chained, open addressing, tagged and inline keyed open
+ * addressing tables, run with time(1) or on its own for the printed per
+ * phase timings.
+ */
+static void cpu03() {
+   char **vocab = benchWords();
+   char **absent = benchWords();
+   HTOptions opts = htDefaultOptions();
+
+   benchWordCount("chained", &opts, vocab, absent);
+   opts.engine = HT_OPEN;
+   benchWordCount("open", &opts, vocab, absent);
+   opts.tagged = 1;
+   benchWordCount("tagged", &opts, vocab, absent);
+   opts.tagged = 0;
+   opts.inlineKeyWidth = 24;
+   opts.keySize = stringSize;
+   benchWordCount("inline", &opts, vocab, absent);
+
+   benchFreeWords(vocab);
+   benchFreeWords(absent);
+}
+
+/* Slowest single htAdd while growing a table from 1021 to about 2M buckets,
+ * once rehashing all at once and once incrementally.
+ */
+static void cpu04() {
+   unsigned i, step;
+   clock_t start, elapsed, worst;
+   char **keys = malloc(1500000 * sizeof(char*));
+   unsigned sizes[] = {1021, 4093, 16381, 65521, 262139, 1048573, 2097143};
+   HTFunctions funcs = {hashString, compareString, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   if (keys == NULL)
+   {
+      perror("cpu04()");
+      exit(EXIT_FAILURE);
+   }
+   for (step = 0; step <= 64; step += 64) {
+      for (i = 0; i < 1500000; i++)
+         keys[i] = randomString();
+      opts.rehashStep = step;
+      ht = htCreateOpts(&funcs, sizes, 7, 0.72, &opts);
+      worst = 0;
+      start = clock();
+      for (i = 0; i < 1500000; i++) {
+         elapsed = clock();
+         if (htAdd(ht, keys[i]) > 1)
+            free(keys[i]);
+         elapsed = clock() - elapsed;
+         worst = (elapsed > worst) ? elapsed : worst;
+      }
+      printf("   rehashStep %-3u total %.3fs  worst htAdd %.3fms\n", step,
+         (double)(clock() - start) / CLOCKS_PER_SEC,
+         1000.0 * worst / CLOCKS_PER_SEC);
+      htDestroy(ht);
+   }
+   free(keys);
+}
+
+/* Full table scans (htToArray, htMetrics) over a million entries with whole
+ * slots versus split slot arrays.
+ */
+static void cpu05() {
+   unsigned i, size, layout;
+   clock_t start;
+   double exportTime, metricsTime;
+   HTEntry *entries;
+   unsigned sizes[] = {2000003};
+   HTFunctions funcs = {hashUnsigned, compareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   opts.engine = HT_OPEN;
+   for (layout = HT_AOS; layout <= HT_SOA; layout++) {
+      opts.layout = layout;
+      ht = htCreateOpts(&funcs, sizes, 1, 1.0, &opts);
+      for (i = 0; i < 1000000; i++)
+         htAdd(ht, newUnsigned(i));
+
+      start = clock();
+      for (i = 0; i < 10; i++)
+         free(htToArray(ht, &size));
+      exportTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+      start = clock();
+      for (i = 0; i < 10; i++)
+         htMetrics(ht);
+      metricsTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+      printf("   %s  10x htToArray %.3fs  10x htMetrics %.3fs\n",
+         layout == HT_AOS ? "HT_AOS" : "HT_SOA", exportTime, metricsTime);
+      entries = htToArray(ht, &size);
+      TEST_UNSIGNED(size, 1000000);
+      free(entries);
+      htDestroy(ht);
+   }
+}
+
+/* Integer keys where the hash is cheap and bucket index reduction matters:
+ * prime capacities (fastmod) versus power of two capacities (mask), and
+ * compareUnsigned versus the htEqualUnsigned equality test.
+ */
+static void cpu06() {
+   unsigned i, pow2, engine;
+   clock_t start;
+   double addTime, lookTime;
+   unsigned primes[] = {1021, 4093, 16381, 65521, 262139, 1048573, 2097143};
+   unsigned powers[] = {1024, 4096, 16384, 65536, 262144, 1048576, 2097152};
+   HTFunctions funcs = {hashUnsigned, compareUnsigned, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   for (engine = HT_CHAINED; engine <= HT_OPEN; engine++) {
+      opts.engine = engine;
+      for (pow2 = 0; pow2 <= 2; pow2++) {
+         /* the third run has prime capacities and an equality test */
+         opts.equal = (pow2 == 2) ? htEqualUnsigned : NULL;
+         ht = htCreateOpts(&funcs, pow2 == 1 ? powers : primes, 7, 0.72,
+            &opts);
+         start = clock();
+         for (i = 0; i < 1000000; i++)
+            htAdd(ht, newUnsigned(i));
+         addTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+         start = clock();
+         for (i = 0; i < 10000000; i++)
+            htLookUp(ht, &i);
+         lookTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+         printf("   %-7s %-6s add %.3fs  10M lookups %.3fs\n",
+            engine == HT_OPEN ? "open" : "chained",
+            pow2 ? (pow2 == 1 ? "pow2" : "equal") : "prime",
+            addTime, lookTime);
+         htDestroy(ht);
+      }
+   }
+}
+
+#define BENCH_TEXT (256 * 1024)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BENCH_CYCLES() ((double)__builtin_ia32_rdtsc())
+#else
+#define BENCH_CYCLES() 0.0
+#endif
+
+/* Chain quality of a 65536 bucket table holding 65536 strings, random ones
+ * or "key0", "key1", ...
+ */
+static void benchStringChains(const char *name,
+   unsigned (*hash)(const void *data), int sequential)
+{
+   unsigned i;
+   char *key;
+   HTMetrics metrics;
+   unsigned sizes[] = {65536};
+   HTFunctions funcs = {NULL, compareString, NULL};
+   void *ht;
+
+   funcs.hash = hash;
+   ht = htCreate(&funcs, sizes, 1, 1.0);
+   for (i = 0; i < 65536; i++) {
+      if (sequential) {
+         key = malloc(16);
+         if (key == NULL)
+         {
+            perror("benchStringChains()");
+            exit(EXIT_FAILURE);
+         }
+         sprintf(key, "key%u", i);
+      } else {
+         key = randomString();
+      }
+      if (htAdd(ht, key) > 1)
+         free(key);
+   }
+   metrics = htMetrics(ht);
+   printf("   %-22s chains %5u  avg %.2f  max %u\n", name,
+      metrics.numberOfChains, metrics.avgChainLength, metrics.maxChainLength);
+   htDestroy(ht);
+}
+
+/* Throughput of the built-in string hash against the K&R hashString on keys
+ * of several lengths (bytes per TSC cycle on x86), then the chain lengths
+ * each hash produces in power of two tables.
+ */
+static void cpu07() {
+   unsigned i, j, len, kr, numKeys;
+   unsigned lengths[] = {8, 32, 256, 4096};
+   volatile unsigned sink = 0;
+   clock_t start;
+   double seconds, cycles, bytes;
+   HTMetrics metrics;
+   char *text = malloc(BENCH_TEXT);
+
+   if (text == NULL)
+   {
+      perror("cpu07()");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < BENCH_TEXT; i++)
+      text[i] = (rand() % ('~' - ' ')) + ' ' + 1;
+   for (j = 0; j < 4; j++) {
+      /* back to back keys so every call hashes different memory */
+      len = lengths[j];
+      numKeys = BENCH_TEXT / (len + 1);
+      for (i = 0; i < numKeys; i++)
+         text[i * (len + 1) + len] = 0;
+      for (kr = 0; kr <= 1; kr++) {
+         bytes = 0;
+         start = clock();
+         cycles = BENCH_CYCLES();
+         for (i = 0; bytes < 256.0 * 1024 * 1024; i++, bytes += len) {
+            if (i == numKeys)
+               i = 0;
+            sink += kr ? hashString(text + i * (len + 1)) :
+               htHashString(text + i * (len + 1));
+         }
+         cycles = BENCH_CYCLES() - cycles;
+         seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+         printf("   %-12s %4u byte keys  %6.0f MB/s  %.2f bytes/cycle\n",
+            kr ? "hashString" : "htHashString", len,
+            bytes / (1024 * 1024) / seconds,
+            cycles > 0 ? bytes / cycles : 0.0);
+      }
+      for (i = 0; i < numKeys; i++)
+         text[i * (len + 1) + len] = 'x';
+   }
+   free(text);
+
+   benchStringChains("random / hashString", hashString, 0);
+   benchStringChains("random / htHashString", htHashString, 0);
+   benchStringChains("keyN / hashString", hashString, 1);
+   benchStringChains("keyN / htHashString", htHashString, 1);
+   for (j = 0; j < 3; j++) {
+      metrics = stridedMetrics(j == 0 ? identityHash : j == 1 ? hashUnsigned :
+         htHashUnsigned, 1024);
+      printf("   %-22s chains %5u  avg %.2f  max %u\n",
+         j == 0 ? "i*1024 / identity" : j == 1 ? "i*1024 / hashUnsigned" :
+         "i*1024 / htHashUnsigned", metrics.numberOfChains,
+         metrics.avgChainLength, metrics.maxChainLength);
+   }
+}
+
+/* Word count over one newline separated buffer: a malloc'd copy per word
+ * handed to htAdd versus htAddSlice on the buffer itself.
+ */
+static void cpu08() {
+   unsigned i, config, slices;
+   size_t len, total = 0;
+   char *text, *word, *end, *copy;
+   clock_t start;
+   char **vocab = benchWords();
+   unsigned sizes[] = {1021, 4093, 16381, 65521, 262139};
+   HTFunctions funcs = {htHashString, htCompareString, NULL};
+   HTOptions opts = htDefaultOptions();
+   void *ht;
+
+   for (i = 0; i < BENCH_WORDS; i++)
+      total += strlen(vocab[(i * 7919) % BENCH_VOCAB]) + 1;
+   if ((text = malloc(total)) == NULL)
+   {
+      perror("cpu08()");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0, word = text; i < BENCH_WORDS; i++) {
+      len = strlen(vocab[(i * 7919) % BENCH_VOCAB]);
+      memcpy(word, vocab[(i * 7919) % BENCH_VOCAB], len);
+      word[len] = '\n';
+      word += len + 1;
+   }
+
+   opts.hashBytes = htHashSlice;
+   for (config = 0; config < 3; config++) {
+      opts.engine = config ? HT_OPEN : HT_CHAINED;
+      opts.inlineKeyWidth = (config == 2) ? 24 : 0;
+      opts.keySize = (config == 2) ? stringSize : NULL;
+      for (slices = 0; slices <= 1; slices++) {
+         ht = htCreateOpts(&funcs, sizes, 5, 0.72, &opts);
+         start = clock();
+         for (word = text; word < text + total; word = end + 1) {
+            end = memchr(word, '\n', text + total - word);
+            if (slices) {
+               htAddSlice(ht, word, end - word);
+               continue;
+            }
+            copy = malloc(end - word + 1);
+            if (copy == NULL)
+            {
+               perror("cpu08()");
+               exit(EXIT_FAILURE);
+            }
+            memcpy(copy, word, end - word);
+            copy[end - word] = 0;
+            if (htAdd(ht, copy) > 1)
+               free(copy);
+         }
+         printf("   %-7s %-6s %-7s %.3fs\n", config ? "open" : "chained",
+            config == 2 ? "inline" : "", slices ? "slices" : "copies",
+            (double)(clock() - start) / CLOCKS_PER_SEC);
+         TEST_UNSIGNED(htTotalEntries(ht), BENCH_WORDS);
+         htDestroy(ht);
+      }
+   }
+   free(text);
+   benchFreeWords(vocab);
+}
+
+/* Integer keys through the generic table (function pointers, malloc'd
+ * keys) versus a generated UIntTable (inlined hash and equality, keys by
+ * value), same hash on both sides.
+ */
+static void cpu09() {
+   unsigned i, engine;
+   clock_t start;
+   double addTime, lookTime;
+   unsigned sizes[] = {1024, 4096, 16384, 65536, 262144, 1048576, 2097152};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   UIntTable ints;
+   void *ht;
+
+   opts.equal = htEqualUnsigned;
+   for (engine = HT_CHAINED; engine <= HT_OPEN; engine++) {
+      opts.engine = engine;
+      ht = htCreateOpts(&funcs, sizes, 7, 0.72, &opts);
+      start = clock();
+      for (i = 0; i < 1000000; i++)
+         htAdd(ht, newUnsigned(i));
+      addTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+      start = clock();
+      for (i = 0; i < 10000000; i++)
+         htLookUp(ht, &i);
+      lookTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+      printf("   %-9s add %.3fs  10M lookups %.3fs\n",
+         engine == HT_OPEN ? "open" : "chained", addTime, lookTime);
+      htDestroy(ht);
+   }
+
+   UIntTableInit(&ints, 1024);
+   start = clock();
+   for (i = 0; i < 1000000; i++)
+      UIntTableAdd(&ints, i);
+   addTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+   start = clock();
+   for (i = 0; i < 10000000; i++)
+      UIntTableLookUp(&ints, i);
+   lookTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+   printf("   %-9s add %.3fs  10M lookups %.3fs\n", "generated", addTime,
+      lookTime);
+   TEST_UNSIGNED(ints.unique, 1000000);
+   UIntTableDestroy(&ints);
+}
+
+static void cpu10() {
+   unsigned i, j, engine, count = 4000000, rounds = 4;
+   unsigned sizes[] = {1024, 65536, 1048576, 4194304, 8388608};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   HTEntry entries[64];
+   unsigned **keys = malloc(count * sizeof(unsigned*));
+   unsigned long found;
+   clock_t start;
+   double singleTime, batchTime;
+   void *ht;
+
+   /* random order lookups in a table far larger than the cache */
+   CHECK_ALLOC(keys);
+   opts.equal = htEqualUnsigned;
+   for (engine = HT_CHAINED; engine <= HT_OPEN; engine++) {
+      opts.engine = engine;
+      ht = htCreateOpts(&funcs, sizes, 5, 0.72, &opts);
+      for (i = 0; i < count; i++)
+         htAdd(ht, newUnsigned(i));
+      for (i = 0; i < count; i++)
+         keys[i] = newUnsigned(htMix32(i) % count);
+
+      found = 0;
+      start = clock();
+      for (j = 0; j < rounds; j++)
+         for (i = 0; i < count; i++)
+            found += htLookUp(ht, keys[i]).frequency;
+      singleTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+      TEST_UNSIGNED(found, (unsigned long)count * rounds);
+
+      found = 0;
+      start = clock();
+      for (j = 0; j < rounds; j++)
+         for (i = 0; i < count; i += 64) {
+            htLookUpBatch(ht, (void**)(keys + i), 64, entries);
+            found += entries[0].frequency + entries[63].frequency;
+         }
+      batchTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+      TEST_UNSIGNED(found, (unsigned long)2 * count / 64 * rounds);
+
+      printf("   %-8s %uM lookups: single %.3fs  batch %.3fs\n",
+         engine == HT_OPEN ? "open" : "chained", count * rounds / 1000000,
+         singleTime, batchTime);
+      for (i = 0; i < count; i++)
+         free(keys[i]);
+      htDestroy(ht);
+   }
+   free(keys);
+}
+
+static void cpu11() {
+   unsigned i, engine, reserve, count = 2000000;
+   unsigned sizes[] = {16, 64, 256, 1024, 4096, 16384, 65536, 262144};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   clock_t start;
+   void *ht;
+
+   /* climbing the ladder and past it against one reservation */
+   opts.equal = htEqualUnsigned;
+   opts.growth = HT_GROW_POW2;
+   for (engine = HT_CHAINED; engine <= HT_OPEN; engine++) {
+      opts.engine = engine;
+      for (reserve = 0; reserve < 2; reserve++) {
+         ht = htCreateOpts(&funcs, sizes, 8, 0.72, &opts);
+         start = clock();
+         if (reserve)
+            htReserve(ht, count);
+         for (i = 0; i < count; i++)
+            htAdd(ht, newUnsigned(i));
+         printf("   %-8s %s 2M adds %.3fs\n",
+            engine == HT_OPEN ? "open" : "chained",
+            reserve ? "reserved" : "climbing",
+            (double)(clock() - start) / CLOCKS_PER_SEC);
+         TEST_UNSIGNED(htCapacity(ht), 4194304);
+         htDestroy(ht);
+      }
+   }
+}
+
+static void cpu12() {
+   unsigned i, size, count = 4000000;
+   unsigned sizes[] = {8388608};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   HTEntry *entries, top[100];
+   clock_t start;
+   void *ht;
+
+   /* top 100 of 4M entries with skewed frequencies */
+   opts.equal = htEqualUnsigned;
+   opts.engine = HT_OPEN;
+   ht = htCreateOpts(&funcs, sizes, 1, 0.72, &opts);
+   for (i = 0; i < count; i++)
+      htAdd(ht, newUnsigned(i));
+   for (i = 0; i < count; i += 1 + htMix32(i) % 64) {
+      for (size = htMix32(i) % 50; size > 0; size--)
+         htAdd(ht, &i);
+   }
+
+   start = clock();
+   entries = htToArray(ht, &size);
+   qsort(entries, size, sizeof(HTEntry), compareFrequency);
+   printf("   htToArray + qsort %.3fs\n",
+      (double)(clock() - start) / CLOCKS_PER_SEC);
+
+   start = clock();
+   htTopK(ht, 100, top);
+   printf("   htTopK            %.3fs\n",
+      (double)(clock() - start) / CLOCKS_PER_SEC);
+   for (i = 0; i < 100; i++)
+      TEST_UNSIGNED(top[i].frequency, entries[i].frequency);
+
+   /* clock() adds up the time of every thread */
+   start = clock();
+   htTopKParallel(ht, 100, top, 4);
+   printf("   htTopKParallel(4) %.3fs cpu\n",
+      (double)(clock() - start) / CLOCKS_PER_SEC);
+   for (i = 0; i < 100; i++)
+      TEST_UNSIGNED(top[i].frequency, entries[i].frequency);
+   free(entries);
+   htDestroy(ht);
+}
+
+/* what one thread of cpu13 works on; lock is NULL for a thread safe table */
+typedef struct
+{
+   void *ht;
+   pthread_mutex_t *lock;
+   unsigned seed;
+   unsigned ops;
+}  MixedWork;
+
+#define MIXED_KEYS 1000000
+
+static void* mixedLoad(void *arg)
+{
+   /* nine lookups per add over a million keys */
+   MixedWork *work = arg;
+   unsigned i, value, *key;
+   for (i = 0; i < work->ops; i++) {
+      value = htMix32(work->seed + i) % MIXED_KEYS;
+      if (work->lock != NULL)
+         pthread_mutex_lock(work->lock);
+      if (i % 10 == 0) {
+         key = newUnsigned(value);
+         if (htAdd(work->ht, key) > 1)
+            free(key);
+      } else {
+         htLookUp(work->ht, &value);
+      }
+      if (work->lock != NULL)
+         pthread_mutex_unlock(work->lock);
+   }
+   return NULL;
+}
+
+static double wallClock()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void cpu13() {
+   unsigned i, t, n, striped, ops = 4000000;
+   unsigned sizes[] = {1024};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   pthread_mutex_t lock;
+   MixedWork work[64];
+   pthread_t ids[64];
+   double start;
+   void *ht;
+
+   /* the same 4M operations split between 1 to 64 threads, on one table
+    * behind a global mutex and on a table with 256 stripes */
+   opts.equal = htEqualUnsigned;
+   opts.growth = HT_GROW_POW2;
+   pthread_mutex_init(&lock, NULL);
+   for (n = 1; n <= 64; n *= 2) {
+      printf("   %2u threads:", n);
+      for (striped = 0; striped < 2; striped++) {
+         opts.stripes = striped ? 256 : 0;
+         ht = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+         for (i = 0; i < MIXED_KEYS; i += 2)
+            htAdd(ht, newUnsigned(i));
+         start = wallClock();
+         for (t = 0; t < n; t++) {
+            work[t].ht = ht;
+            work[t].lock = striped ? NULL : &lock;
+            work[t].seed = t * ops;
+            work[t].ops = ops / n;
+            if (pthread_create(ids + t, NULL, mixedLoad, work + t) != 0) {
+               perror("cpu13()");
+               exit(EXIT_FAILURE);
+            }
+         }
+         for (t = 0; t < n; t++)
+            pthread_join(ids[t], NULL);
+         printf("  %s %.3fs", striped ? "striped" : "global mutex",
+            wallClock() - start);
+         htDestroy(ht);
+      }
+      printf("\n");
+   }
+   pthread_mutex_destroy(&lock);
+}
+
+/* hot keys of cpu14, all in the table before the threads start */
+#define HOT_KEYS 64
+
+static void* hotLoad(void *arg)
+{
+   /* adds of keys already present, so nothing is allocated or kept */
+   MixedWork *work = arg;
+   unsigned i, value;
+   for (i = 0; i < work->ops; i++) {
+      value = htMix32(work->seed + i) % HOT_KEYS;
+      if (work->lock != NULL)
+         pthread_mutex_lock(work->lock);
+      htAdd(work->ht, &value);
+      if (work->lock != NULL)
+         pthread_mutex_unlock(work->lock);
+   }
+   return NULL;
+}
+
+static void cpu14() {
+   unsigned i, t, n, kind, ops = 8000000;
+   unsigned sizes[] = {1024};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   const char *names[] = {"global mutex", "striped", "atomic"};
+   pthread_mutex_t lock;
+   MixedWork work[64];
+   pthread_t ids[64];
+   double start;
+   void *ht;
+
+   /* 8M increments of 64 hot keys split between 1 to 64 threads, behind a
+    * global mutex, with 256 stripes and lock-free */
+   opts.equal = htEqualUnsigned;
+   pthread_mutex_init(&lock, NULL);
+   for (n = 1; n <= 64; n *= 2) {
+      printf("   %2u threads:", n);
+      for (kind = 0; kind < 3; kind++) {
+         opts.stripes = (kind == 1) ? 256 : 0;
+         opts.engine = (kind == 2) ? HT_ATOMIC : HT_CHAINED;
+         ht = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+         for (i = 0; i < HOT_KEYS; i++)
+            htAdd(ht, newUnsigned(i));
+         start = wallClock();
+         for (t = 0; t < n; t++) {
+            work[t].ht = ht;
+            work[t].lock = (kind == 0) ? &lock : NULL;
+            work[t].seed = t * ops;
+            work[t].ops = ops / n;
+            if (pthread_create(ids + t, NULL, hotLoad, work + t) != 0) {
+               perror("cpu14()");
+               exit(EXIT_FAILURE);
+            }
+         }
+         for (t = 0; t < n; t++)
+            pthread_join(ids[t], NULL);
+         printf("  %s %.3fs", names[kind], wallClock() - start);
+         TEST_UNSIGNED(htTotalEntries(ht), HOT_KEYS + n * (ops / n));
+         htDestroy(ht);
+      }
+      printf("\n");
+   }
+   pthread_mutex_destroy(&lock);
+}
+
+static void** mergeShards(unsigned count, unsigned adds)
+{
+   /* cpu15's shards: the same skewed key space counted separately */
+   unsigned s, i, *key;
+   unsigned sizes[] = {1024};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   void **shards = malloc(count * sizeof(void*));
+   CHECK_ALLOC(shards);
+   opts.equal = htEqualUnsigned;
+   opts.growth = HT_GROW_POW2;
+   for (s = 0; s < count; s++) {
+      shards[s] = htCreateOpts(&funcs, sizes, 1, 0.75, &opts);
+      for (i = 0; i < adds; i++) {
+         key = newUnsigned(htMix32(s * adds + i) % (adds / (1 + i % 4)));
+         if (htAdd(shards[s], key) > 1)
+            free(key);
+      }
+   }
+   return shards;
+}
+
+static void cpu15() {
+   unsigned s, i, f, count = 8, adds = 1000000, size, *key;
+   unsigned long total = (unsigned long)count * adds;
+   HTEntry *entries;
+   double start;
+   void **shards, *ht;
+
+   /* eight shards of 1M adds each combined by re-adding every entry, by
+    * htMerge one after the other and by htMergeParallel */
+   shards = mergeShards(count, adds);
+   start = wallClock();
+   for (s = 1; s < count; s++) {
+      entries = htToArray(shards[s], &size);
+      for (i = 0; i < size; i++) {
+         for (f = 0; f < entries[i].frequency; f++) {
+            key = newUnsigned(*(unsigned*)entries[i].data);
+            if (htAdd(shards[0], key) > 1)
+               free(key);
+         }
+      }
+      free(entries);
+      htDestroy(shards[s]);
+   }
+   printf("   htToArray + htAdd  %.3fs\n", wallClock() - start);
+   TEST_UNSIGNED(htTotalEntries(shards[0]), total);
+   htDestroy(shards[0]);
+   free(shards);
+
+   shards = mergeShards(count, adds);
+   start = wallClock();
+   for (s = 1; s < count; s++)
+      htMerge(shards[0], shards[s]);
+   printf("   htMerge            %.3fs\n", wallClock() - start);
+   TEST_UNSIGNED(htTotalEntries(shards[0]), total);
+   htDestroy(shards[0]);
+   free(shards);
+
+   shards = mergeShards(count, adds);
+   start = wallClock();
+   ht = htMergeParallel(shards, count);
+   printf("   htMergeParallel    %.3fs\n", wallClock() - start);
+   TEST_UNSIGNED(htTotalEntries(ht), total);
+   htDestroy(ht);
+   free(shards);
+}
+
+static void cpu16() {
+   unsigned i, threads, count = 6000000;
+   unsigned sizes[] = {8388608, 16777216};
+   HTFunctions funcs = {htHashUnsigned, NULL, NULL};
+   HTOptions opts = htDefaultOptions();
+   double start;
+   void *ht;
+
+   /* one rehash of 6M entries from 8M to 16M buckets on 1 to 32 threads */
+   opts.equal = htEqualUnsigned;
+   for (threads = 1; threads <= 32; threads *= 2) {
+      opts.rehashThreads = threads;
+      ht = htCreateOpts(&funcs, sizes, 2, 0.75, &opts);
+      for (i = 0; i < count; i++)
+         htAdd(ht, newUnsigned(i));
+      start = wallClock();
+      htReserve(ht, 7000000);
+      printf("   %2u threads: %.3fs\n", threads, wallClock() - start);
+      TEST_UNSIGNED(htCapacity(ht), 16777216);
+      htDestroy(ht);
+   }
+}
+
 static void testAll(Test* tests)
 {
    int i;
@@ -967,6 +3327,38 @@ Test* initRegularTests()
       {feat07, "feat07"},
       {feat08, "feat08"},
       {feat09, "feat09"},
+      {feat10, "feat10"},
+      {feat11, "feat11"},
+      {feat12, "feat12"},
+      {feat13, "feat13"},
+      {feat14, "feat14"},
+      {feat15, "feat15"},
+      {feat16, "feat16"},
+      {feat17, "feat17"},
+      {feat18, "feat18"},
+      {feat19, "feat19"},
+      {feat20, "feat20"},
+      {feat21, "feat21"},
+      {feat22, "feat22"},
+      {feat23, "feat23"},
+      {feat24, "feat24"},
+      {feat25, "feat25"},
+      {feat26, "feat26"},
+      {feat27, "feat27"},
+      {feat28, "feat28"},
+      {feat29, "feat29"},
+      {feat30, "feat30"},
+      {feat31, "feat31"},
+      {feat32, "feat32"},
+      {feat33, "feat33"},
+      {feat34, "feat34"},
+      {feat35, "feat35"},
+      {feat36, "feat36"},
+      {feat37, "feat37"},
+      {feat38, "feat38"},
+      {feat39, "feat39"},
+      {feat40, "feat40"},
+      {feat41, "feat41"},
       {cpu02, "cpu02"},
       {heap01, "heap01"},
       {NULL, NULL}
@@ -1010,6 +3402,20 @@ Test* initSpecialTests()
       {core08, "core08"},
       {core09, "core09"},
       {core10, "core10"},
+      {cpu03, "cpu03"},
+      {cpu04, "cpu04"},
+      {cpu05, "cpu05"},
+      {cpu06, "cpu06"},
+      {cpu07, "cpu07"},
+      {cpu08, "cpu08"},
+      {cpu09, "cpu09"},
+      {cpu10, "cpu10"},
+      {cpu11, "cpu11"},
+      {cpu12, "cpu12"},
+      {cpu13, "cpu13"},
+      {cpu14, "cpu14"},
+      {cpu15, "cpu15"},
+      {cpu16, "cpu16"},
       {NULL, NULL}
    };
 